@@ -0,0 +1,265 @@
+// Headless physics benchmark: no GLFW, no GraphicsAPI.
+//   ./build/bench --scene pile --count 10000 --frames 600 --csv pile.csv --json pile.json
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#define ARENA_IMPLEMENTATION
+#include "arena2.h"
+
+#include "game_api.h"
+#include "graphics_api.h"
+#include "mesh.h"
+#include "scene.h"
+#include "physics.cpp"
+#include "scene.cpp"
+
+struct BenchArgs
+{
+  SceneParams scene;
+  u32 frames = 600;
+  u32 warmup = 60;
+  r32 dt = 1.0f / 60.0f;
+  const char *csv_path = nullptr;
+  const char *json_path = nullptr;
+  const char *config_path = nullptr; // default: sized from the scene
+  const char *trace_path = nullptr;  // Chrome trace of the measured frames
+};
+
+struct BenchFrame
+{
+  r64 step_ms;
+  u32 active_bodies;
+  u32 contacts;
+};
+
+// Counts contact pairs (new + persisted) touched by the last step
+class BenchContactCounter : public JPH::ContactListener
+{
+public:
+  virtual void OnContactAdded(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, JPH::ContactSettings &ioSettings) override
+  {
+    contacts.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  virtual void OnContactPersisted(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, JPH::ContactSettings &ioSettings) override
+  {
+    contacts.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::atomic<u32> contacts{0};
+};
+
+static r64 bench_now_ms()
+{
+  using namespace std::chrono;
+  return duration<r64, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void print_usage(const char *exe)
+{
+  fprintf(stderr,
+          "usage: %s [--scene stack|pile|mixed|motorcycles] [--count N] [--frames N]\n"
+          "          [--warmup N] [--seed N] [--csv path] [--json path] [--config path]\n"
+          "          [--trace path]\n",
+          exe);
+}
+
+static bool parse_args(int argc, char **argv, BenchArgs *args)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    if (!value)
+      return false;
+
+    if (strcmp(arg, "--scene") == 0)
+    {
+      u32 type_count = sizeof(scene_type_names) / sizeof(scene_type_names[0]);
+      u32 t = 0;
+      for (; t < type_count; ++t)
+        if (strcmp(value, scene_type_names[t]) == 0)
+          break;
+      if (t == type_count)
+        return false;
+      args->scene.type = (SceneType)t;
+    }
+    else if (strcmp(arg, "--count") == 0)
+      args->scene.count = (u32)atoi(value);
+    else if (strcmp(arg, "--frames") == 0)
+      args->frames = (u32)atoi(value);
+    else if (strcmp(arg, "--warmup") == 0)
+      args->warmup = (u32)atoi(value);
+    else if (strcmp(arg, "--seed") == 0)
+      args->scene.seed = (u32)atoi(value);
+    else if (strcmp(arg, "--csv") == 0)
+      args->csv_path = value;
+    else if (strcmp(arg, "--json") == 0)
+      args->json_path = value;
+    else if (strcmp(arg, "--config") == 0)
+      args->config_path = value;
+    else if (strcmp(arg, "--trace") == 0)
+      args->trace_path = value;
+    else
+      return false;
+    ++i;
+  }
+  return args->frames > 0;
+}
+
+int main(int argc, char **argv)
+{
+  BenchArgs args = {};
+  if (!parse_args(argc, argv, &args))
+  {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  Arena *arena = arena_alloc(TB(64), KB(64), 0);
+  profiler_set_thread_name("main");
+
+  GameMemory *memory = push_struct(arena, GameMemory);
+  memory->arena = arena;
+  memory->gfx = nullptr;
+
+  u32 requested_bodies = scene_object_count(args.scene);
+  PhysicsConfig config = args.config_path ? physics_config_load(args.config_path) : physics_config_for_bodies(requested_bodies);
+  memory->physics_config = &config;
+
+  init_physics(memory);
+  PhysicsState *physics = memory->physics;
+  if (!physics_check_budget(physics, requested_bodies))
+    return EXIT_FAILURE;
+
+  BenchContactCounter *contact_counter = new (push_struct(arena, BenchContactCounter)) BenchContactCounter();
+  physics->physics_system->SetContactListener(contact_counter);
+
+  memory->render_context_count = 1;
+  memory->render_contexts = push_array(arena, RenderContext, memory->render_context_count);
+  RenderContext *ctx = &memory->render_contexts[0];
+
+  r64 spawn_start = bench_now_ms();
+  spawn_scene(memory, ctx, args.scene);
+  r64 spawn_ms = bench_now_ms() - spawn_start;
+
+  u32 spawned = 0;
+  for (u32 i = 1; i < ctx->objects_count; ++i)
+    if (!ctx->objects[i].body_id->IsInvalid())
+      spawned++;
+
+  const char *scene_name = scene_type_names[(s32)args.scene.type];
+  printf("scene=%s requested=%u spawned=%u bodies=%u spawn=%.2fms\n",
+         scene_name, args.scene.count, spawned, physics->physics_system->GetNumBodies(), spawn_ms);
+  if (memory->geometry_cache)
+    printf("geometry cache: meshes=%u hits=%u misses=%u\n", memory->geometry_cache->count,
+           memory->geometry_cache->hits, memory->geometry_cache->misses);
+  ShapeCache *shapes = physics->shape_cache;
+  printf("shape cache: shapes=%u hits=%u misses=%u hit rate=%.1f%%\n", shapes->count, shapes->hits, shapes->misses,
+         100.0 * shapes->hits / (shapes->hits + shapes->misses ? shapes->hits + shapes->misses : 1));
+  if (spawned < args.scene.count)
+    fprintf(stderr, "warning: %u bodies could not be created (PhysicsSystem full)\n", args.scene.count - spawned);
+
+  for (u32 i = 0; i < args.warmup; ++i)
+    step_physics(physics, args.dt);
+
+  physics->job_system->reset_worker_stats(); // only the measured frames count
+  profiler_frame_end(1);                     // spawn and warmup go into a window of their own
+  BenchFrame *frames = push_array(arena, BenchFrame, args.frames);
+  for (u32 i = 0; i < args.frames; ++i)
+  {
+    contact_counter->contacts.store(0, std::memory_order_relaxed);
+
+    r64 start = bench_now_ms();
+    step_physics(physics, args.dt);
+    frames[i].step_ms = bench_now_ms() - start;
+
+    frames[i].active_bodies = physics->physics_system->GetNumActiveBodies(JPH::EBodyType::RigidBody);
+    frames[i].contacts = contact_counter->contacts.load(std::memory_order_relaxed);
+    profiler_frame_end(args.frames);
+  }
+
+  r64 *sorted = push_array(arena, r64, args.frames);
+  r64 total_ms = 0.0;
+  r64 total_active = 0.0;
+  r64 total_contacts = 0.0;
+  for (u32 i = 0; i < args.frames; ++i)
+  {
+    sorted[i] = frames[i].step_ms;
+    total_ms += frames[i].step_ms;
+    total_active += frames[i].active_bodies;
+    total_contacts += frames[i].contacts;
+  }
+  std::sort(sorted, sorted + args.frames);
+
+  r64 min_ms = sorted[0];
+  r64 median_ms = sorted[args.frames / 2];
+  r64 p99_ms = sorted[std::min(args.frames - 1, (u32)(0.99 * (args.frames - 1) + 0.5))];
+  r64 max_ms = sorted[args.frames - 1];
+  r64 mean_ms = total_ms / args.frames;
+  r64 mean_active = total_active / args.frames;
+  r64 mean_contacts = total_contacts / args.frames;
+
+  printf("frames=%u min=%.3fms median=%.3fms p99=%.3fms max=%.3fms mean=%.3fms\n",
+         args.frames, min_ms, median_ms, p99_ms, max_ms, mean_ms);
+  printf("active_bodies(avg)=%.1f contacts(avg)=%.1f\n", mean_active, mean_contacts);
+  physics_report_workers(physics, false);
+  physics_report_allocations(physics);
+  profiler_print_summary(stdout);
+  JoltTempArenaAllocator *temp = physics->temp_allocator;
+  printf("temp allocator: peak=%.2fMB capacity=%.2fMB overflow=%.2fMB in %u blocks\n", temp->get_peak() / (r64)MB(1),
+         temp->get_capacity() / (r64)MB(1), temp->get_overflow_bytes() / (r64)MB(1), temp->get_overflow_blocks());
+
+  if (args.csv_path)
+  {
+    FILE *file = fopen(args.csv_path, "wb");
+    if (!file)
+    {
+      fprintf(stderr, "Failed to open %s\n", args.csv_path);
+      return EXIT_FAILURE;
+    }
+    fprintf(file, "frame,step_ms,active_bodies,contacts\n");
+    for (u32 i = 0; i < args.frames; ++i)
+      fprintf(file, "%u,%.6f,%u,%u\n", i, frames[i].step_ms, frames[i].active_bodies, frames[i].contacts);
+    fclose(file);
+  }
+
+  if (args.json_path)
+  {
+    FILE *file = fopen(args.json_path, "wb");
+    if (!file)
+    {
+      fprintf(stderr, "Failed to open %s\n", args.json_path);
+      return EXIT_FAILURE;
+    }
+    fprintf(file,
+            "{\n"
+            "  \"scene\": \"%s\",\n"
+            "  \"requested\": %u,\n"
+            "  \"spawned\": %u,\n"
+            "  \"bodies\": %u,\n"
+            "  \"seed\": %u,\n"
+            "  \"frames\": %u,\n"
+            "  \"dt\": %.6f,\n"
+            "  \"spawn_ms\": %.3f,\n"
+            "  \"step_ms\": {\"min\": %.6f, \"median\": %.6f, \"p99\": %.6f, \"max\": %.6f, \"mean\": %.6f},\n"
+            "  \"active_bodies_avg\": %.1f,\n"
+            "  \"contacts_avg\": %.1f,\n"
+            "  \"temp_peak_bytes\": %llu\n"
+            "}\n",
+            scene_name, args.scene.count, spawned, physics->physics_system->GetNumBodies(), args.scene.seed,
+            args.frames, args.dt, spawn_ms, min_ms, median_ms, p99_ms, max_ms, mean_ms, mean_active, mean_contacts,
+            (unsigned long long)temp->get_peak());
+    fclose(file);
+  }
+
+  if (args.trace_path && !profiler_write_chrome_trace(args.trace_path))
+    return EXIT_FAILURE;
+
+  physics->physics_system->SetContactListener(nullptr);
+  return EXIT_SUCCESS;
+}
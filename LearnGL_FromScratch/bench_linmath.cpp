@@ -0,0 +1,181 @@
+// linmath SIMD backend vs scalar: timing plus a bit-exactness / tolerance check.
+//   ./build/bench_linmath --count 100000 --iterations 50
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+
+#include "defines.h"
+#include "linmath.h"
+
+#define LINMATH_OPS(name) simd_##name
+#include "bench_linmath_ops.inl"
+
+void scalar_mul(mat4x4 *out, const mat4x4 *a, const mat4x4 *b, u32 count);
+void scalar_mul_vec4(vec4 *out, const mat4x4 *m, const vec4 *v, u32 count);
+void scalar_invert(mat4x4 *out, const mat4x4 *m, u32 count);
+void scalar_look_at(mat4x4 *out, const vec4 *eye, const vec4 *center, u32 count);
+void scalar_perspective(mat4x4 *out, const vec4 *params, u32 count);
+void scalar_quat_mul(quat *out, const quat *p, const quat *q, u32 count);
+
+static r64 bench_now_ms()
+{
+  using namespace std::chrono;
+  return duration<r64, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static r32 rand_range(u32 *state, r32 lo, r32 hi)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return lo + (hi - lo) * ((*state >> 8) * (1.0f / 16777216.0f));
+}
+
+struct OpResult
+{
+  const char *name;
+  r64 scalar_ms;
+  r64 simd_ms;
+  u32 mismatched; // floats that differ (+0 and -0 count as equal)
+  r32 max_error;  // relative to max(1, |reference|)
+  r32 tolerance;
+};
+
+static void compare(OpResult *result, const r32 *reference, const r32 *simd, u32 floats)
+{
+  result->mismatched = 0;
+  result->max_error = 0.0f;
+  for (u32 i = 0; i < floats; ++i)
+  {
+    if (reference[i] != simd[i])
+      result->mismatched++;
+    result->max_error = fmaxf(result->max_error, fabsf(reference[i] - simd[i]) / fmaxf(1.0f, fabsf(reference[i])));
+  }
+}
+
+// Median of `iterations` runs of `body`
+#define TIME_MEDIAN(out_ms, body)           \
+  do                                        \
+  {                                         \
+    for (u32 it_ = 0; it_ < iterations; ++it_) \
+    {                                       \
+      r64 start_ = bench_now_ms();          \
+      body;                                 \
+      samples[it_] = bench_now_ms() - start_; \
+    }                                       \
+    std::sort(samples, samples + iterations); \
+    out_ms = samples[iterations / 2];       \
+  } while (0)
+
+int main(int argc, char **argv)
+{
+  u32 count = 100000;
+  u32 iterations = 50;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (strcmp(argv[i], "--count") == 0)
+      count = (u32)atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--iterations") == 0)
+      iterations = (u32)atoi(argv[i + 1]);
+    else
+    {
+      fprintf(stderr, "usage: %s [--count N] [--iterations N]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (count == 0 || iterations == 0)
+    return EXIT_FAILURE;
+
+  mat4x4 *a = (mat4x4 *)malloc(sizeof(mat4x4) * count);
+  mat4x4 *b = (mat4x4 *)malloc(sizeof(mat4x4) * count);
+  mat4x4 *out_scalar = (mat4x4 *)malloc(sizeof(mat4x4) * count);
+  mat4x4 *out_simd = (mat4x4 *)malloc(sizeof(mat4x4) * count);
+  vec4 *v = (vec4 *)malloc(sizeof(vec4) * count);
+  vec4 *w = (vec4 *)malloc(sizeof(vec4) * count);
+  vec4 *params = (vec4 *)malloc(sizeof(vec4) * count);
+  r64 *samples = (r64 *)malloc(sizeof(r64) * iterations);
+
+  u32 seed = 1;
+  for (u32 i = 0; i < count; ++i)
+  {
+    // Rigid transform + scale keeps invert well conditioned
+    quat q = {rand_range(&seed, -1, 1), rand_range(&seed, -1, 1), rand_range(&seed, -1, 1), rand_range(&seed, -1, 1)};
+    quat_norm(q, q);
+    mat4x4_from_quat(a[i], q);
+    mat4x4_scale_aniso(a[i], a[i], rand_range(&seed, 0.5f, 2.0f), rand_range(&seed, 0.5f, 2.0f), rand_range(&seed, 0.5f, 2.0f));
+    a[i][3][0] = rand_range(&seed, -50, 50);
+    a[i][3][1] = rand_range(&seed, -50, 50);
+    a[i][3][2] = rand_range(&seed, -50, 50);
+
+    for (int c = 0; c < 4; ++c)
+      for (int r = 0; r < 4; ++r)
+        b[i][c][r] = rand_range(&seed, -2, 2);
+
+    for (int k = 0; k < 4; ++k)
+    {
+      v[i][k] = rand_range(&seed, -10, 10);
+      w[i][k] = rand_range(&seed, -10, 10);
+    }
+    params[i][0] = rand_range(&seed, 0.5f, 2.0f);
+    params[i][1] = rand_range(&seed, 0.5f, 2.5f);
+    params[i][2] = rand_range(&seed, 0.01f, 1.0f);
+    params[i][3] = rand_range(&seed, 10.0f, 1000.0f);
+  }
+
+  // Unit quats for quat_mul live in v/w
+  quat *qa = (quat *)malloc(sizeof(quat) * count);
+  quat *qb = (quat *)malloc(sizeof(quat) * count);
+  for (u32 i = 0; i < count; ++i)
+  {
+    quat_norm(qa[i], v[i]);
+    quat_norm(qb[i], w[i]);
+  }
+
+  OpResult results[6] = {
+      {"mat4x4_mul", 0, 0, 0, 0, 0.0f},
+      {"mat4x4_mul_vec4", 0, 0, 0, 0, 0.0f},
+      {"mat4x4_invert", 0, 0, 0, 0, 0.0f},
+      {"mat4x4_look_at", 0, 0, 0, 0, 0.0f},
+      {"mat4x4_perspective", 0, 0, 0, 0, 0.0f},
+      {"quat_mul", 0, 0, 0, 0, 1e-6f},
+  };
+
+  TIME_MEDIAN(results[0].scalar_ms, scalar_mul(out_scalar, a, b, count));
+  TIME_MEDIAN(results[0].simd_ms, simd_mul(out_simd, a, b, count));
+  compare(&results[0], (r32 *)out_scalar, (r32 *)out_simd, 16 * count);
+
+  TIME_MEDIAN(results[1].scalar_ms, scalar_mul_vec4((vec4 *)out_scalar, a, v, count));
+  TIME_MEDIAN(results[1].simd_ms, simd_mul_vec4((vec4 *)out_simd, a, v, count));
+  compare(&results[1], (r32 *)out_scalar, (r32 *)out_simd, 4 * count);
+
+  TIME_MEDIAN(results[2].scalar_ms, scalar_invert(out_scalar, a, count));
+  TIME_MEDIAN(results[2].simd_ms, simd_invert(out_simd, a, count));
+  compare(&results[2], (r32 *)out_scalar, (r32 *)out_simd, 16 * count);
+
+  TIME_MEDIAN(results[3].scalar_ms, scalar_look_at(out_scalar, v, w, count));
+  TIME_MEDIAN(results[3].simd_ms, simd_look_at(out_simd, v, w, count));
+  compare(&results[3], (r32 *)out_scalar, (r32 *)out_simd, 16 * count);
+
+  TIME_MEDIAN(results[4].scalar_ms, scalar_perspective(out_scalar, params, count));
+  TIME_MEDIAN(results[4].simd_ms, simd_perspective(out_simd, params, count));
+  compare(&results[4], (r32 *)out_scalar, (r32 *)out_simd, 16 * count);
+
+  TIME_MEDIAN(results[5].scalar_ms, scalar_quat_mul((quat *)out_scalar, qa, qb, count));
+  TIME_MEDIAN(results[5].simd_ms, simd_quat_mul((quat *)out_simd, qa, qb, count));
+  compare(&results[5], (r32 *)out_scalar, (r32 *)out_simd, 4 * count);
+
+  printf("count=%u iterations=%u simd=%d\n", count, iterations, LINMATH_SIMD);
+  printf("%-20s %12s %12s %8s %10s %12s\n", "op", "scalar(ms)", "simd(ms)", "speedup", "mismatch", "max_error");
+  bool ok = true;
+  for (u32 i = 0; i < sizeof(results) / sizeof(results[0]); ++i)
+  {
+    OpResult *r = &results[i];
+    bool pass = r->max_error <= r->tolerance;
+    ok = ok && pass;
+    printf("%-20s %12.4f %12.4f %7.2fx %10u %12g %s\n", r->name, r->scalar_ms, r->simd_ms,
+           r->scalar_ms / r->simd_ms, r->mismatched, r->max_error, pass ? "ok" : "FAIL");
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,39 @@
+// Batch loops over the linmath hot ops, included once per backend.
+// Define LINMATH_OPS(name) before including to prefix the function names.
+
+void LINMATH_OPS(mul)(mat4x4 *out, const mat4x4 *a, const mat4x4 *b, u32 count)
+{
+  for (u32 i = 0; i < count; ++i)
+    mat4x4_mul(out[i], a[i], b[i]);
+}
+
+void LINMATH_OPS(mul_vec4)(vec4 *out, const mat4x4 *m, const vec4 *v, u32 count)
+{
+  for (u32 i = 0; i < count; ++i)
+    mat4x4_mul_vec4(out[i], m[i], v[i]);
+}
+
+void LINMATH_OPS(invert)(mat4x4 *out, const mat4x4 *m, u32 count)
+{
+  for (u32 i = 0; i < count; ++i)
+    mat4x4_invert(out[i], m[i]);
+}
+
+void LINMATH_OPS(look_at)(mat4x4 *out, const vec4 *eye, const vec4 *center, u32 count)
+{
+  vec3 up = {0.0f, 1.0f, 0.0f};
+  for (u32 i = 0; i < count; ++i)
+    mat4x4_look_at(out[i], eye[i], center[i], up);
+}
+
+void LINMATH_OPS(perspective)(mat4x4 *out, const vec4 *params, u32 count)
+{
+  for (u32 i = 0; i < count; ++i)
+    mat4x4_perspective(out[i], params[i][0], params[i][1], params[i][2], params[i][3]);
+}
+
+void LINMATH_OPS(quat_mul)(quat *out, const quat *p, const quat *q, u32 count)
+{
+  for (u32 i = 0; i < count; ++i)
+    quat_mul(out[i], p[i], q[i]);
+}
@@ -0,0 +1,179 @@
+// Per-object vs instanced submission: N objects over a handful of shared meshes.
+//   ./build/bench_render --count 10000 --frames 300 [--layout packed|separate]
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+
+#define ARENA_IMPLEMENTATION
+#include "arena2.h"
+
+#include "game_api.h"
+#include "graphics_api.h"
+#include "mesh.h"
+#include "shader.h"
+#include "render.cpp"
+
+static r64 bench_now_ms()
+{
+  using namespace std::chrono;
+  return duration<r64, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static r32 bench_rand(u32 *state, r32 lo, r32 hi)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return lo + (hi - lo) * ((*state >> 8) * (1.0f / 16777216.0f));
+}
+
+struct ModeResult
+{
+  r64 submit_ms; // median CPU time spent in render_context_draw
+  r64 frame_ms;  // median including swap (GPU bound once submit is cheap)
+  u32 draw_calls;
+};
+
+static ModeResult run_mode(GraphicsAPI *gfx, GLFWwindow *window, RenderContext *ctx, const mat4x4 *models,
+                           mat4x4 view, mat4x4 projection, u32 frames, r64 *samples, r64 *frame_samples)
+{
+  vec3 light_pos = {8.0f, 5.0f, 8.0f};
+  vec3 eye = {0.0f, 60.0f, 120.0f};
+  GraphicsStats stats = {};
+
+  for (u32 f = 0; f < frames + 10; ++f)
+  {
+    r64 frame_start = bench_now_ms();
+    gfx->clear(0.0f, 0.0f, 0.0f, 1.0f);
+    gfx->read_stats(&stats, true);
+
+    r64 start = bench_now_ms();
+    render_context_draw(gfx, ctx, models, 0, ~0u, (const r32 *)view, (const r32 *)projection, light_pos, eye);
+    r64 submit = bench_now_ms() - start;
+
+    gfx->read_stats(&stats, true);
+    gfx->swap_buffers(window);
+    glfwPollEvents();
+
+    if (f >= 10) // warmup
+    {
+      samples[f - 10] = submit;
+      frame_samples[f - 10] = bench_now_ms() - frame_start;
+    }
+  }
+
+  std::sort(samples, samples + frames);
+  std::sort(frame_samples, frame_samples + frames);
+  return {samples[frames / 2], frame_samples[frames / 2], stats.draw_calls};
+}
+
+int main(int argc, char **argv)
+{
+  u32 count = 10000;
+  u32 frames = 300;
+  VertexLayout layout = VertexLayout::PACKED;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (strcmp(argv[i], "--count") == 0)
+      count = (u32)atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--frames") == 0)
+      frames = (u32)atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--layout") == 0)
+      layout = strcmp(argv[i + 1], "separate") == 0 ? VertexLayout::SEPARATE : VertexLayout::PACKED;
+    else
+    {
+      fprintf(stderr, "usage: %s [--count N] [--frames N] [--layout packed|separate]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (count == 0 || frames == 0)
+    return EXIT_FAILURE;
+
+  if (!glfwInit())
+    return EXIT_FAILURE;
+
+  GraphicsAPI *gfx = create_graphics_api_opengl();
+  gfx->set_window_hints();
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  GLFWwindow *window = glfwCreateWindow(1280, 720, "bench_render", NULL, NULL);
+  if (!window || !gfx->init(window))
+  {
+    fprintf(stderr, "Failed to create GL context\n");
+    return EXIT_FAILURE;
+  }
+  glfwSwapInterval(0);
+
+  Arena *arena = arena_alloc(GB(16), KB(64), 0);
+
+  GeometryCache *cache = geometry_cache_create(arena, 4, layout);
+  Mesh *meshes[4] = {
+      geometry_cache_get(cache, arena, gfx, geometry_key(MeshPrimitive::BOX, 0.5f, 0.5f, 0.5f)),
+      geometry_cache_get(cache, arena, gfx, geometry_key(MeshPrimitive::SPHERE, 0.5f, 0.0f, 0.0f, 36, 18)),
+      geometry_cache_get(cache, arena, gfx, geometry_key(MeshPrimitive::CYLINDER, 0.5f, 1.0f, 0.0f, 36)),
+      geometry_cache_get(cache, arena, gfx, geometry_key(MeshPrimitive::CONE, 0.5f, 1.0f, 0.0f, 36)),
+  };
+
+  RenderContext ctx = {};
+  ctx.shader = Shader::create_basic(arena, gfx);
+  ctx.instanced_shader = Shader::create_instanced(arena, gfx);
+  ctx.objects_count = count;
+  ctx.objects = push_array(arena, Object, count);
+
+  mat4x4 *models = (mat4x4 *)arena_push(arena, sizeof(mat4x4) * count, 32, true);
+  u32 seed = 1;
+  u32 side = 1;
+  while (side * side < count)
+    side++;
+  for (u32 i = 0; i < count; ++i)
+  {
+    Object *object = &ctx.objects[i];
+    object->mesh = meshes[i % 4];
+    object->type = ObjectType::BOX;
+    object->color[0] = bench_rand(&seed, 0.2f, 1.0f);
+    object->color[1] = bench_rand(&seed, 0.2f, 1.0f);
+    object->color[2] = bench_rand(&seed, 0.2f, 1.0f);
+
+    quat q = {bench_rand(&seed, -1, 1), bench_rand(&seed, -1, 1), bench_rand(&seed, -1, 1), bench_rand(&seed, -1, 1)};
+    quat_norm(q, q);
+    mat4x4_from_quat(models[i], q);
+    models[i][3][0] = ((r32)(i % side) - side * 0.5f) * 1.5f;
+    models[i][3][1] = bench_rand(&seed, 0.0f, 4.0f);
+    models[i][3][2] = ((r32)(i / side) - side * 0.5f) * 1.5f;
+  }
+
+  render_context_build_batches(arena, gfx, &ctx);
+  InstanceBatch *batches = ctx.batches;
+
+  vec3 eye = {0.0f, 60.0f, 120.0f};
+  vec3 center = {0.0f, 0.0f, 0.0f};
+  vec3 up = {0.0f, 1.0f, 0.0f};
+  mat4x4 view, projection;
+  mat4x4_look_at(view, eye, center, up);
+  mat4x4_perspective(projection, 1.047f, 1280.0f / 720.0f, 0.1f, 1000.0f);
+  gfx->enable_depth_test();
+
+  r64 *samples = push_array(arena, r64, frames);
+  r64 *frame_samples = push_array(arena, r64, frames);
+
+  ctx.batches = nullptr;
+  ModeResult per_object = run_mode(gfx, window, &ctx, models, view, projection, frames, samples, frame_samples);
+  ctx.batches = batches;
+  ModeResult instanced = run_mode(gfx, window, &ctx, models, view, projection, frames, samples, frame_samples);
+
+  u32 vertex_bytes = 0;
+  for (Mesh *mesh : meshes)
+    vertex_bytes += mesh->vertex_count * (layout == VertexLayout::PACKED ? sizeof(PackedVertex) : 9 * sizeof(r32));
+  printf("objects=%u meshes=4 batches=%u frames=%u layout=%s vertex bytes=%u\n", count, ctx.batch_count, frames,
+         layout == VertexLayout::PACKED ? "packed" : "separate", vertex_bytes);
+  printf("%-12s %10s %12s %12s\n", "mode", "draws", "submit(ms)", "frame(ms)");
+  printf("%-12s %10u %12.3f %12.3f\n", "per-object", per_object.draw_calls, per_object.submit_ms, per_object.frame_ms);
+  printf("%-12s %10u %12.3f %12.3f\n", "instanced", instanced.draw_calls, instanced.submit_ms, instanced.frame_ms);
+  printf("submit speedup=%.1fx draw calls /%.0f\n", per_object.submit_ms / instanced.submit_ms,
+         (r64)per_object.draw_calls / (instanced.draw_calls ? instanced.draw_calls : 1));
+
+  glfwDestroyWindow(window);
+  glfwTerminate();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+// Pose -> model matrix microbenchmark: per-object quat path vs pose_batch_to_mat4.
+//   ./build/bench_transforms --count 10000 --iterations 200
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+
+#define ARENA_IMPLEMENTATION
+#include "arena2.h"
+
+#include "game_api.h"
+#include "linmath.h"
+#include "transform_batch.h"
+
+static r64 bench_now_ms()
+{
+  using namespace std::chrono;
+  return duration<r64, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static TransformSoA push_soa(Arena *arena, u32 stride)
+{
+  r32 *block = (r32 *)arena_push(arena, 7 * stride * sizeof(r32), 32, true);
+  return {block, block + stride, block + 2 * stride, block + 3 * stride, block + 4 * stride, block + 5 * stride, block + 6 * stride};
+}
+
+static r32 rand_range(u32 *state, r32 lo, r32 hi)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return lo + (hi - lo) * ((*state >> 8) * (1.0f / 16777216.0f));
+}
+
+static void fill_random(TransformSoA *t, u32 count, u32 *state)
+{
+  for (u32 i = 0; i < count; ++i)
+  {
+    t->px[i] = rand_range(state, -100.0f, 100.0f);
+    t->py[i] = rand_range(state, 0.0f, 50.0f);
+    t->pz[i] = rand_range(state, -100.0f, 100.0f);
+    quat q = {rand_range(state, -1, 1), rand_range(state, -1, 1), rand_range(state, -1, 1), rand_range(state, -1, 1)};
+    quat_norm(q, q);
+    t->qx[i] = q[0];
+    t->qy[i] = q[1];
+    t->qz[i] = q[2];
+    t->qw[i] = q[3];
+  }
+}
+
+// What game_render did per object before the batch kernel
+static void reference_pose(mat4x4 M, const TransformSoA *a, const TransformSoA *b, r32 t, u32 i)
+{
+  r32 dot = a->qx[i] * b->qx[i] + a->qy[i] * b->qy[i] + a->qz[i] * b->qz[i] + a->qw[i] * b->qw[i];
+  r32 sign = dot < 0.0f ? -1.0f : 1.0f;
+  quat q = {
+      a->qx[i] * (1.0f - t) + b->qx[i] * t * sign,
+      a->qy[i] * (1.0f - t) + b->qy[i] * t * sign,
+      a->qz[i] * (1.0f - t) + b->qz[i] * t * sign,
+      a->qw[i] * (1.0f - t) + b->qw[i] * t * sign,
+  };
+  quat_norm(q, q);
+
+  mat4x4_from_quat(M, q);
+  M[3][0] = a->px[i] + (b->px[i] - a->px[i]) * t;
+  M[3][1] = a->py[i] + (b->py[i] - a->py[i]) * t;
+  M[3][2] = a->pz[i] + (b->pz[i] - a->pz[i]) * t;
+}
+
+int main(int argc, char **argv)
+{
+  u32 count = 10000;
+  u32 iterations = 200;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (strcmp(argv[i], "--count") == 0)
+      count = (u32)atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--iterations") == 0)
+      iterations = (u32)atoi(argv[i + 1]);
+    else
+    {
+      fprintf(stderr, "usage: %s [--count N] [--iterations N]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (count == 0 || iterations == 0)
+    return EXIT_FAILURE;
+
+  Arena *arena = arena_alloc(GB(4), KB(64), 0);
+  u32 stride = (count + 7) & ~7u;
+  TransformSoA prev = push_soa(arena, stride);
+  TransformSoA curr = push_soa(arena, stride);
+  u32 seed = 1;
+  fill_random(&prev, count, &seed);
+  fill_random(&curr, count, &seed);
+
+  mat4x4 *reference = (mat4x4 *)arena_push(arena, sizeof(mat4x4) * stride, 32, true);
+  mat4x4 *batched = (mat4x4 *)arena_push(arena, sizeof(mat4x4) * stride, 32, true);
+  r32 *normals = (r32 *)arena_push(arena, 12 * sizeof(r32) * stride, 32, true);
+
+  r64 *reference_ms = push_array(arena, r64, iterations);
+  r64 *batched_ms = push_array(arena, r64, iterations);
+  r64 *normals_ms = push_array(arena, r64, iterations);
+
+  for (u32 it = 0; it < iterations; ++it)
+  {
+    r32 alpha = (it % 16) / 16.0f;
+
+    r64 start = bench_now_ms();
+    for (u32 i = 0; i < count; ++i)
+      reference_pose(reference[i], &prev, &curr, alpha, i);
+    reference_ms[it] = bench_now_ms() - start;
+
+    start = bench_now_ms();
+    pose_batch_to_mat4(&prev, &curr, alpha, 0, count, (r32 *)batched, nullptr);
+    batched_ms[it] = bench_now_ms() - start;
+
+    start = bench_now_ms();
+    pose_batch_to_mat4(&prev, &curr, alpha, 0, count, (r32 *)batched, normals);
+    normals_ms[it] = bench_now_ms() - start;
+  }
+
+  // Both paths ran with the same alpha on the last iteration
+  r32 max_error = 0.0f;
+  for (u32 i = 0; i < count; ++i)
+  {
+    const r32 *r = (const r32 *)reference[i];
+    const r32 *b = (const r32 *)batched[i];
+    const r32 *n = normals + 12 * i;
+    for (int k = 0; k < 16; ++k)
+      max_error = fmaxf(max_error, fabsf(r[k] - b[k]) / fmaxf(1.0f, fabsf(r[k])));
+    for (int k = 0; k < 12; ++k)
+      max_error = fmaxf(max_error, fabsf(n[k] - b[k]));
+  }
+
+  std::sort(reference_ms, reference_ms + iterations);
+  std::sort(batched_ms, batched_ms + iterations);
+  std::sort(normals_ms, normals_ms + iterations);
+  r64 ref = reference_ms[iterations / 2];
+  r64 bat = batched_ms[iterations / 2];
+  r64 nrm = normals_ms[iterations / 2];
+
+  printf("count=%u iterations=%u width=%d\n", count, iterations, POSE_BATCH_WIDTH);
+  printf("per-object  median=%.4fms (%.2f ns/pose)\n", ref, ref * 1e6 / count);
+  printf("batched     median=%.4fms (%.2f ns/pose) speedup=%.2fx\n", bat, bat * 1e6 / count, ref / bat);
+  printf("+normals    median=%.4fms (%.2f ns/pose)\n", nrm, nrm * 1e6 / count);
+  printf("max error=%g\n", max_error);
+
+  return max_error < 1e-4f ? EXIT_SUCCESS : EXIT_FAILURE;
+}
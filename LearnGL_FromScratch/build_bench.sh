@@ -0,0 +1,70 @@
+#!/bin/bash
+
+# Configuration
+JOLT_ROOT="${JOLT_ROOT:-$HOME/Developer/JoltPhysics}"
+BUILD_DIR="build"
+OUTPUT="$BUILD_DIR/bench"
+
+# Headless: no GLFW / OpenGL, runs on a Linux box with no display
+if [ "$(uname)" == "Darwin" ]; then
+    JOLT_LIB="${JOLT_LIB:-$JOLT_ROOT/Build/XCode_MacOS/libJolt.a}"
+    ARCH="-arch arm64"
+    INCLUDES="-I$JOLT_ROOT -I/opt/homebrew/include"
+else
+    JOLT_LIB="${JOLT_LIB:-$JOLT_ROOT/Build/Linux_Release/libJolt.a}"
+    ARCH=""
+    INCLUDES="-I$JOLT_ROOT"
+fi
+
+# Compiler flags
+CXX="${CXX:-clang++}"
+CXXFLAGS="-std=c++23 $ARCH -Wno-error -g -O2"
+DEFINES="-DJPH_OBJECT_STREAM -DJPH_DEBUG_RENDERER"
+# Jolt's internal zones in the profiler, needs a libJolt built with the same define
+[ -n "$JOLT_EXTERNAL_PROFILE" ] && DEFINES="$DEFINES -DJPH_EXTERNAL_PROFILE"
+WARNINGS="-Wno-all"
+
+# Linker flags
+LIBS="-lpthread"
+
+# Create build directory
+mkdir -p $BUILD_DIR
+
+
+# Build
+echo "Building $OUTPUT..."
+$CXX $CXXFLAGS $DEFINES $INCLUDES $WARNINGS \
+    bench.cpp mesh.cpp \
+    $JOLT_LIB \
+    $LIBS \
+    -o $OUTPUT
+
+if [ $? -eq 0 ]; then
+    echo "✓ Build successful: ./$OUTPUT"
+else
+    echo "✗ Build failed"
+    exit 1
+fi
+
+# Transform kernel microbenchmark, no Jolt needed so it can take AVX2 on x86
+SIMD=""
+[ "$(uname -m)" == "x86_64" ] && SIMD="-mavx2"
+echo "Building $BUILD_DIR/bench_transforms..."
+$CXX $CXXFLAGS $SIMD $WARNINGS bench_transforms.cpp -o $BUILD_DIR/bench_transforms || exit 1
+echo "✓ Build successful: ./$BUILD_DIR/bench_transforms"
+
+# linmath SIMD vs scalar (scalar reference lives in its own TU)
+echo "Building $BUILD_DIR/bench_linmath..."
+$CXX $CXXFLAGS $WARNINGS bench_linmath.cpp linmath_scalar.cpp -o $BUILD_DIR/bench_linmath || exit 1
+echo "✓ Build successful: ./$BUILD_DIR/bench_linmath"
+
+# Instanced vs per-object rendering, needs a GL context (macOS only, like the game)
+if [ "$(uname)" == "Darwin" ]; then
+    echo "Building $BUILD_DIR/bench_render..."
+    $CXX $CXXFLAGS $DEFINES -DGL_SILENCE_DEPRECATION $INCLUDES $WARNINGS \
+        bench_render.cpp graphics_api_gl.cpp mesh.cpp shader.cpp \
+        $JOLT_LIB \
+        -L/opt/homebrew/lib -lglfw -framework OpenGL -framework Cocoa -framework IOKit \
+        -o $BUILD_DIR/bench_render || exit 1
+    echo "✓ Build successful: ./$BUILD_DIR/bench_render"
+fi
@@ -4,17 +4,22 @@
 #include "linmath.h"
 #include "mesh.h"
 #include "shader.h"
+#include "transform_batch.h"
 #include <stdio.h>
 #include <assert.h>
 #include "physics.cpp"
+#include "scene.cpp"
+#include "render.cpp"
 
 extern "C"
 {
+  Arena *arena_alloc(u64 reserve_size, u64 commit_size, ArenaFlags flags) __attribute__((weak));
   void *arena_push(Arena *arena, u64 size, u64 align, b32 zero) __attribute__((weak));
   Temp temp_begin(Arena *arena) __attribute__((weak));
   void temp_end(Temp temp) __attribute__((weak));
 
 
+  Arena *arena_alloc(u64 reserve_size, u64 commit_size, ArenaFlags flags) {}
   void *arena_push(Arena *arena, u64 size, u64 align, b32 zero) {}
   Temp temp_begin(Arena *arena) {};
   void temp_end(Temp temp) {};
@@ -37,77 +42,6 @@ static void compute_camera_basis(r32 yaw, r32 pitch, vec3 forward, vec3 right)
   vec3_norm(right, right);
 }
 
-void create_object(GameMemory *memory, JPH::BodyInterface &body_interface, Object *object, ObjectType type, CreateObjectParams params)
-{
-  GraphicsAPI *gfx = memory->gfx;
-  Arena *arena = memory->arena;
-
-  JPH::Vec3 jolt_pos(params.loc[0], params.loc[1], params.loc[2]);
-  JPH::EMotionType motion = (type == ObjectType::GROUND) ? JPH::EMotionType::Static : JPH::EMotionType::Dynamic;
-  JPH::ObjectLayer layer = (type == ObjectType::GROUND) ? Layers::NON_MOVING : Layers::MOVING;
-  JPH::EActivation activation = (type == ObjectType::GROUND) ? JPH::EActivation::DontActivate : JPH::EActivation::Activate;
-
-  JPH::ShapeSettings::ShapeResult shape_result;
-
-  switch (type)
-  {
-  case ObjectType::GROUND:
-  {
-    object->mesh = Mesh::create_ground(arena, gfx, params.size[0], params.color[0], params.color[1], params.color[2]);
-    // object->mesh = Mesh::create_box(arena, gfx, params.size[0], 0.1f, params.size[0], params.color[0], params.color[1], params.color[2]);
-
-    JPH::BoxShapeSettings shape(JPH::Vec3(params.size[0], 0.1f, params.size[0]));
-    shape_result = shape.Create();
-    jolt_pos = JPH::Vec3(0, -0.1f, 0);
-    break;
-  }
-  case ObjectType::BOX:
-  {
-    object->mesh = Mesh::create_box(arena, gfx, params.size[0], params.size[1], params.size[2], params.color[0], params.color[1], params.color[2]);
-    object->mesh->translate(params.loc[0], params.loc[1], params.loc[2]);
-
-    JPH::BoxShapeSettings shape(JPH::Vec3(params.size[0], params.size[1], params.size[2]));
-    shape_result = shape.Create();
-    break;
-  }
-  case ObjectType::SPHERE:
-  {
-    object->mesh = Mesh::create_sphere(arena, gfx, params.size[0], 36, 18,
-                                       params.color[0], params.color[1], params.color[2]);
-    object->mesh->translate(params.loc[0], params.loc[1], params.loc[2]);
-
-    JPH::SphereShapeSettings shape(params.size[0]);
-    shape_result = shape.Create();
-    break;
-  }
-  case ObjectType::CYLINDER:
-  {
-    object->mesh = Mesh::create_cylinder(arena, gfx, params.size[0], params.size[1], 36,
-                                         params.color[0], params.color[1], params.color[2]);
-    object->mesh->translate(params.loc[0], params.loc[1], params.loc[2]);
-
-    JPH::CylinderShapeSettings shape(params.size[1] * 0.5f, params.size[0]);
-    shape_result = shape.Create();
-    break;
-  }
-  case ObjectType::CONE:
-  {
-    object->mesh = Mesh::create_cone(arena, gfx, params.size[0], params.size[1], 36,
-                                     params.color[0], params.color[1], params.color[2]);
-    object->mesh->translate(params.loc[0], params.loc[1], params.loc[2]);
-
-    JPH::ConvexHullShapeSettings convex_settings = object->mesh->create_convex_hull();
-    shape_result = convex_settings.Create();
-    break;
-  }
-  }
-
-  JPH::BodyCreationSettings body_settings(shape_result.Get(), jolt_pos, JPH::Quat::sIdentity(), motion, layer);
-  object->body_id = push_struct(arena, JPH::BodyID);
-  *object->body_id = body_interface.CreateAndAddBody(body_settings, activation);
-  object->type = type;
-}
-
 extern "C"
 {
   void game_init(GameMemory *memory)
@@ -122,6 +56,7 @@ extern "C"
     memory->yaw = 90.0f;
     memory->pitch = 0.0f;
 
+    profiler_set_thread_name("main");
     init_physics(memory);
 
     memory->render_context_count = 1;
@@ -130,10 +65,13 @@ extern "C"
     RenderContext *ctx = (RenderContext *)&memory->render_contexts[r_idx++];
 
     ctx->shader = Shader::create_basic(arena, gfx);
+    ctx->instanced_shader = Shader::create_instanced(arena, gfx);
 
-    ctx->objects_count = 5;
+    render_context_alloc(arena, ctx, 5);
     s32 o_idx = 0;
-    ctx->objects = push_array(arena, Object, ctx->objects_count);
+
+    bool budget_ok = physics_check_budget(memory->physics, ctx->objects_count);
+    assert(budget_ok && "physics budget too small for scene");
 
     JPH::BodyInterface &body_interface = memory->physics->physics_system->GetBodyInterface();
 
@@ -144,6 +82,11 @@ extern "C"
     create_object(memory, body_interface, &ctx->objects[o_idx++], ObjectType::CYLINDER, {{1.0f, 2}, {0, 10.f, 0.0f}, {.8, .8, .2}});
 
     memory->physics->physics_system->OptimizeBroadPhase();
+    render_context_build_batches(arena, gfx, ctx);
+
+    init_body_poses(memory);
+    if (memory->physics->config.pipelined)
+      physics_pipeline_start(memory);
 
     assert(o_idx <= ctx->objects_count && "objects_count MISMATCH");
     assert(r_idx == memory->render_context_count && "render_context_count MISMATCH");
@@ -152,6 +95,14 @@ extern "C"
 
   void game_update(GameMemory *memory, GameInput *input)
   {
+    // Frame boundary, the previous frame's render is complete. Prints every PROFILER_WINDOW_FRAMES frames.
+    if (memory->physics->config.profile_report && profiler_frame_end())
+    {
+      profiler_print_summary(stdout);
+      physics_report_debug_draw(memory->physics);
+    }
+
+    PROFILE_SCOPE("game_update");
     r32 dt = input->deltat_for_frame;
     r32 speed = 5.0f;
 
@@ -198,35 +149,15 @@ extern "C"
       memory->camera[2] -= right[2] * speed * dt;
     }
 
-    memory->physics->temp_allocator->Clear();
-    // Update physics (1 collision step)
-    memory->physics->physics_system->Update(dt, 1, memory->physics->temp_allocator, memory->physics->job_system);
-
-    // Sync physics bodies to render meshes
-    JPH::BodyInterface &body_interface = memory->physics->physics_system->GetBodyInterface();
-
-    for (int i = 0; i < memory->render_context_count; ++i)
-    {
-      RenderContext *ctx = &memory->render_contexts[i];
-      for (int j = 0; j < ctx->objects_count; ++j)
-      {
-        JPH::Vec3 position = body_interface.GetPosition(*ctx->objects[j].body_id);
-        JPH::Quat rotation = body_interface.GetRotation(*ctx->objects[j].body_id);
-
-        quat q = {rotation.GetX(), rotation.GetY(), rotation.GetZ(), rotation.GetW()};
-
-        // Update mesh transform - dereference the pointer
-        mat4x4_from_quat(*ctx->objects[j].mesh->model, q);
-        (*ctx->objects[j].mesh->model)[3][0] = position.GetX();
-        (*ctx->objects[j].mesh->model)[3][1] = position.GetY();
-        (*ctx->objects[j].mesh->model)[3][2] = position.GetZ();
-      }
-    }
-
+    if (physics_pipeline_running(memory->physics))
+      physics_pipeline_frame(memory, dt);
+    else
+      simulate_physics_frame(memory, memory->poses, dt);
   }
 
   void game_render(GameMemory *memory)
   {
+    PROFILE_SCOPE("game_render");
     GraphicsAPI *gfx = memory->gfx;
 
     vec3 forward, right;
@@ -247,35 +178,60 @@ extern "C"
     mat4x4 perspective = {};
     mat4x4_perspective(perspective, 1.047f, (r32)memory->width / memory->height, 0.1f, 100.0f);
 
-    for (int i = 0; i < memory->render_context_count; ++i)
+    // Only poses touched by the last simulated frame need new model matrices,
+    // unless frames were skipped (pipelined) and their dirty ranges are lost
+    PoseBuffer *poses = memory->poses;
+    u32 dirty_begin = poses->dirty_begin;
+    u32 dirty_end = poses->dirty_end;
+    if (poses->sequence != memory->pose_sequence_seen && poses->sequence != memory->pose_sequence_seen + 1)
     {
-      RenderContext *ctx = &memory->render_contexts[i];
-      Shader *shader = ctx->shader;
-
-      shader->use(gfx);
-
-      shader->set_mat4(gfx, "view", (const r32 *)view);
-      shader->set_mat4(gfx, "projection", (const r32 *)perspective);
-      shader->set_vec3(gfx, "light_pos", light_pos);
-      shader->set_vec3(gfx, "view_pos", memory->camera);
-
-      for (int j = 0; j < ctx->objects_count; ++j)
+      dirty_begin = 0;
+      dirty_end = poses->count;
+    }
+    memory->pose_sequence_seen = poses->sequence;
+    if (dirty_end > dirty_begin)
+    {
+      // Same pool as the physics step, so a pipelined step and this share the workers
+      r32 *models = (r32 *)memory->models;
+      auto to_mat4 = [poses, dirty_begin, models](u32 begin, u32 end)
       {
-        shader->set_mat4(gfx, "model", (const r32 *)ctx->objects[j].mesh->model);
-        ctx->objects[j].mesh->draw(gfx);
-      }
+        pose_batch_to_mat4(&poses->prev, &poses->curr, poses->alpha, dirty_begin + begin, dirty_begin + end, models, nullptr);
+      };
+      memory->physics->job_system->parallel_for("PoseToMat4", dirty_end - dirty_begin, 4096, to_mat4);
     }
+
+    for (int i = 0; i < memory->render_context_count; ++i)
+      render_context_draw(gfx, &memory->render_contexts[i], memory->models, dirty_begin, dirty_end,
+                          (const r32 *)view, (const r32 *)perspective, light_pos, memory->camera);
+
     if (memory->physics->debug_draw_enabled)
+    {
+      // DrawBodies reads live bodies, it must not overlap a step
+      if (physics_pipeline_running(memory->physics))
+        physics_pipeline_wait_idle(memory->physics->pipeline);
       draw_physics(memory, view, perspective);
+    }
+  }
+
+  // The physics thread runs code from this dylib, park it before it is unloaded
+  void game_before_reload(GameMemory *memory)
+  {
+    physics_pipeline_stop(memory);
   }
 
   void game_hot_reloaded(GameMemory *memory)
   {
+    profiler_set_thread_name("main"); // the reloaded code has its own, empty profiler
+    if (memory->physics->config.pipelined)
+      physics_pipeline_start(memory);
     printf("===== GAME CODE HOT RELOADED =====\n");
   }
 
   void game_shutdown(GameMemory *memory)
   {
+    physics_pipeline_stop(memory);
+    if (memory->physics->config.profile_report)
+      profiler_write_chrome_trace("trace.json");
     printf("Game shutdown\n");
   }
 
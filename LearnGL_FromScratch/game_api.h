@@ -8,8 +8,10 @@
 
 
 struct Mesh;
+struct GeometryCache;
 struct GraphicsAPI;
 struct PhysicsState;
+struct PhysicsConfig;
 namespace JPH { class BodyID; }
 
 enum class ObjectType
@@ -19,6 +21,7 @@ enum class ObjectType
   SPHERE,
   CYLINDER,
   CONE,
+  MOTORCYCLE,
 };
 
 struct CreateObjectParams
@@ -32,13 +35,51 @@ typedef struct
   Mesh *mesh;
   JPH::BodyID *body_id;
   ObjectType type;
+  vec3 color; // per-instance color for the instanced path
 } Object;
 
+// Objects of one RenderContext sharing a Mesh, drawn with one instanced call
+typedef struct InstanceBatch
+{
+  Mesh *mesh;
+  u32 *objects;   // indices into RenderContext::objects
+  u32 count;
+  r32 *matrices;  // staging, 16 floats per instance
+  GraphicsBuffer matrix_vbo;
+  GraphicsBuffer color_vbo;
+  bool uploaded;  // matrix_vbo holds every instance, later frames upload the dirty range
+} InstanceBatch;
+
+// Body transforms as SoA streams, indexed by pose index (= body user data)
+typedef struct TransformSoA
+{
+  r32 *px, *py, *pz;
+  r32 *qx, *qy, *qz, *qw;
+} TransformSoA;
+
+// Poses before/after the last fixed step, all RenderContexts back to back
+typedef struct PoseBuffer
+{
+  TransformSoA prev;
+  TransformSoA curr;
+  u32 count;
+  u32 stride;   // floats per stream, multiple of 8
+  r32 alpha;    // blend factor for rendering
+  u32 dirty_begin, dirty_end; // poses touched by the last simulated frame, [begin, end)
+  u32 sequence; // bumped per simulated frame, a gap means dirty ranges were missed
+} PoseBuffer;
+
 typedef struct RenderContext
 {
   Shader *shader;
   Object *objects;
   u32 objects_count = 0;
+  u32 pose_base; // first pose of this context in PoseBuffer
+
+  // Set by render_context_build_batches(), otherwise one draw per object with `shader`
+  Shader *instanced_shader;
+  InstanceBatch *batches;
+  u32 batch_count;
 } RenderContext;
 
 typedef struct GameMemory
@@ -51,6 +92,12 @@ typedef struct GameMemory
   vec3 camera;
   r32 yaw, pitch;
   PhysicsState *physics;
+  PhysicsConfig *physics_config; // optional override, otherwise physics.cfg / defaults
+  PoseBuffer *poses;             // what game_render interpolates
+  mat4x4 *models;                // one per pose, rebuilt from poses over the dirty range
+  GeometryCache *geometry_cache; // shared meshes for create_object, created on first use
+  u32 pose_count;
+  u32 pose_sequence_seen;
 } GameMemory;
 
 typedef struct GameButtonState
@@ -101,6 +148,7 @@ typedef struct GameAPI
   void (*init)(GameMemory *);
   void (*update)(GameMemory *, GameInput *);
   void (*render)(GameMemory *);
+  void (*before_reload)(GameMemory *);
   void (*hot_reloaded)(GameMemory *);
   void (*shutdown)(GameMemory *);
 } GameAPI;
@@ -11,6 +11,30 @@ typedef void *GraphicsBuffer;
 typedef void *GraphicsShader;
 typedef void *GraphicsProgram;
 typedef void *GraphicsVertexArray;
+typedef void *GraphicsStreamBuffer;
+
+// Uniform location resolved from the program's link-time table, UNIFORM_NONE if absent
+typedef s32 UniformHandle;
+#define UNIFORM_NONE -1
+
+// Counted by the backend since the last reset
+struct GraphicsStats
+{
+  u32 draw_calls;
+  u32 instances;
+  u32 stream_stalls; // stream_buffer_begin had to wait for the GPU
+  u32 stream_grows;
+  u64 stream_bytes;  // written through stream buffers
+};
+
+// Component type of a vertex attribute. Packed formats are normalized on fetch,
+// so shaders still see floats
+enum VertexAttribType
+{
+  VERTEX_ATTRIB_FLOAT,
+  VERTEX_ATTRIB_SNORM_10_10_10_2, // 4 components in one u32, x in the low bits
+  VERTEX_ATTRIB_UNORM8,
+};
 
 enum ShaderType
 {
@@ -33,14 +57,21 @@ struct GraphicsAPI
   GraphicsBuffer (*create_index_buffer)(Arena *arena, const void *data, size_t size);
   void (*bind_index_buffer)(GraphicsBuffer buffer);
   void (*draw_elements)(int count);
+  void (*draw_elements_instanced)(int count, int instance_count);
 
   void (*set_int)(GraphicsProgram program, const char *name, s32 data);
   void (*set_float)(GraphicsProgram program, const char *name, r32 data);
   void (*set_vec3)(GraphicsProgram program, const char *name, const r32 *data);
   void (*set_vec4)(GraphicsProgram program, const char *name, const r32 *data);
   void (*set_mat4)(GraphicsProgram program, const char *name, const r32 *data);
-  void (*set_uniform_mat4)(GraphicsProgram program, int location, const float *data);
-  void (*set_uniform_vec3)(GraphicsProgram program, int location, const float *data);
+
+  // Pre-resolved handles: one GL call per set, UNIFORM_NONE is ignored
+  UniformHandle (*find_uniform)(GraphicsProgram program, const char *name);
+  void (*set_uniform_int)(GraphicsProgram program, UniformHandle handle, s32 data);
+  void (*set_uniform_float)(GraphicsProgram program, UniformHandle handle, r32 data);
+  void (*set_uniform_vec3)(GraphicsProgram program, UniformHandle handle, const r32 *data);
+  void (*set_uniform_vec4)(GraphicsProgram program, UniformHandle handle, const r32 *data);
+  void (*set_uniform_mat4)(GraphicsProgram program, UniformHandle handle, const r32 *data);
 
   void (*bind_buffer)(GraphicsBuffer buffer);
   void (*bind_vertex_array)(GraphicsVertexArray vao);
@@ -50,6 +81,8 @@ struct GraphicsAPI
   int (*get_uniform_location)(GraphicsProgram program, const char *name);
   void (*enable_vertex_attrib)(int location);
   void (*vertex_attrib_pointer)(int location, int size, int stride, size_t offset);
+  void (*vertex_attrib_format_pointer)(int location, int size, VertexAttribType type, int stride, size_t offset);
+  void (*vertex_attrib_divisor)(int location, int divisor);
 
   void (*clear)(float r, float g, float b, float a);
   void (*viewport)(int x, int y, int width, int height);
@@ -66,8 +99,24 @@ struct GraphicsAPI
   void (*enable_depth_test)();
   void (*disable_depth_test)();
   void (*set_line_width)(float width);
+  void (*set_wireframe)(bool enabled); // rasterize triangles as lines, culling off
   void (*update_buffer_data)(GraphicsBuffer buffer, const void *data, size_t size);
+  void (*update_buffer_range)(GraphicsBuffer buffer, size_t offset, const void *data, size_t size);
   void (*draw_line_arrays)(s32 first, s32 count);
+
+  // Per-frame data (instance attributes): allocated once, refilled with update_buffer_data
+  GraphicsBuffer (*create_dynamic_buffer)(Arena *arena, size_t size);
+  void (*read_stats)(GraphicsStats *stats, bool reset);
+
+  // Streaming vertex data written straight into mapped memory. The buffer is split into
+  // frame-sized regions used round-robin, each fenced until the GPU has read it.
+  //   begin: maps a region of at least size bytes (grows the buffer if needed), at most once per frame
+  //   end:   flushes the first used bytes, binds the buffer to the vertex array target and returns
+  //          the region's byte offset, to be added to the vertex_attrib_pointer offsets
+  GraphicsStreamBuffer (*create_stream_buffer)(Arena *arena, size_t frame_size);
+  void *(*stream_buffer_begin)(GraphicsStreamBuffer stream, size_t size);
+  size_t (*stream_buffer_end)(GraphicsStreamBuffer stream, size_t used);
+  void (*bind_stream_buffer)(GraphicsStreamBuffer stream); // rebinds it after other buffers were bound
 };
 
 GraphicsAPI *create_graphics_api_opengl();
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string.h>
 #include "arena2.h"
 
 struct GLBuffer
@@ -17,16 +18,84 @@ struct GLShader
   GLuint id;
 };
 
+struct GLUniform
+{
+  u32 hash;
+  s32 location;
+  const char *name;
+};
+
 struct GLProgram
 {
   GLuint id;
+  GLUniform *uniforms; // active uniforms, filled once after linking
+  u32 uniform_count;
 };
 
+// FNV-1a
+static u32 gl_uniform_hash(const char *name)
+{
+  u32 hash = 2166136261u;
+  for (; *name; ++name)
+    hash = (hash ^ (u8)*name) * 16777619u;
+  return hash;
+}
+
+static void gl_build_uniform_table(Arena *arena, GLProgram *program)
+{
+  GLint count = 0;
+  GLint max_length = 0;
+  glGetProgramiv(program->id, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program->id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+  program->uniforms = push_array(arena, GLUniform, count);
+  program->uniform_count = 0;
+  for (GLint i = 0; i < count; ++i)
+  {
+    char *name = push_array(arena, char, max_length + 1);
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(program->id, i, max_length + 1, &length, &size, &type, name);
+
+    // Arrays come back as "name[0]", look them up by the bare name
+    if (length > 3 && strcmp(name + length - 3, "[0]") == 0)
+      name[length - 3] = '\0';
+
+    s32 location = glGetUniformLocation(program->id, name);
+    if (location == -1) // uniform block members
+      continue;
+
+    GLUniform *uniform = &program->uniforms[program->uniform_count++];
+    uniform->hash = gl_uniform_hash(name);
+    uniform->location = location;
+    uniform->name = name;
+  }
+}
+
 struct GLVertexArray
 {
   GLuint id;
 };
 
+static GraphicsStats s_gl_stats;
+static bool s_gl_buffer_storage; // ARB_buffer_storage, persistent mapping
+
+#define GL_STREAM_REGIONS 3
+
+// Triple-buffered ring. With buffer storage the whole buffer stays mapped; otherwise each
+// region is mapped unsynchronized for the frame, the fences keep it safe either way.
+struct GLStreamBuffer
+{
+  GLuint id;
+  size_t region_size;
+  u32 region;      // last region handed out
+  bool in_flight;  // that region was ended and still needs its fence
+  GLsync fences[GL_STREAM_REGIONS];
+  u8 *persistent;  // whole buffer, nullptr when mapping per frame
+  u8 *mapped;      // current region while between begin and end
+};
+
 static void gl_set_window_hints()
 {
   // OpenGL 4.1 Core Profile (macOS maximum)
@@ -46,6 +115,17 @@ static bool gl_init(GLFWwindow *window)
   printf("OpenGL Renderer: %s\n", glGetString(GL_RENDERER));
   printf("OpenGL Version: %s\n", glGetString(GL_VERSION));
 
+#ifdef GL_MAP_PERSISTENT_BIT
+  GLint major = 0, minor = 0, extensions = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+  s_gl_buffer_storage = major > 4 || (major == 4 && minor >= 4);
+  for (GLint i = 0; i < extensions && !s_gl_buffer_storage; ++i)
+    s_gl_buffer_storage = strcmp((const char *)glGetStringi(GL_EXTENSIONS, i), "GL_ARB_buffer_storage") == 0;
+#endif
+  printf("OpenGL persistent mapping: %s\n", s_gl_buffer_storage ? "yes" : "no");
+
   return true;
 }
 
@@ -103,8 +183,10 @@ static GraphicsProgram gl_create_program(Arena *arena, GraphicsShader vertex, Gr
     char info_log[512];
     glGetProgramInfoLog(program->id, 512, NULL, info_log);
     fprintf(stderr, "Program linking failed: %s\n", info_log);
+    return program;
   }
 
+  gl_build_uniform_table(arena, program);
   return program;
 }
 
@@ -147,7 +229,14 @@ static s32 gl_get_attrib_location(GraphicsProgram program, const char *name)
 static s32 gl_get_uniform_location(GraphicsProgram program, const char *name)
 {
   GLProgram *prog = (GLProgram *)program;
-  return glGetUniformLocation(prog->id, name);
+  u32 hash = gl_uniform_hash(name);
+  for (u32 i = 0; i < prog->uniform_count; ++i)
+  {
+    GLUniform *uniform = &prog->uniforms[i];
+    if (uniform->hash == hash && strcmp(uniform->name, name) == 0)
+      return uniform->location;
+  }
+  return UNIFORM_NONE;
 }
 
 static void gl_enable_vertex_attrib(s32 location)
@@ -160,6 +249,27 @@ static void gl_vertex_attrib_pointer(s32 location, s32 size, s32 stride, size_t
   glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, stride, (void *)offset);
 }
 
+static void gl_vertex_attrib_format_pointer(s32 location, s32 size, VertexAttribType type, s32 stride, size_t offset)
+{
+  switch (type)
+  {
+  case VERTEX_ATTRIB_FLOAT:
+    glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, stride, (void *)offset);
+    break;
+  case VERTEX_ATTRIB_SNORM_10_10_10_2:
+    glVertexAttribPointer(location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void *)offset);
+    break;
+  case VERTEX_ATTRIB_UNORM8:
+    glVertexAttribPointer(location, size, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void *)offset);
+    break;
+  }
+}
+
+static void gl_vertex_attrib_divisor(s32 location, s32 divisor)
+{
+  glVertexAttribDivisor(location, divisor);
+}
+
 static void gl_clear(r32 r, r32 g, r32 b, r32 a)
 {
   glClearColor(r, g, b, a);
@@ -174,6 +284,7 @@ static void gl_viewport(s32 x, s32 y, s32 width, s32 height)
 static void gl_draw_arrays(s32 first, s32 count)
 {
   glDrawArrays(GL_TRIANGLES, first, count);
+  s_gl_stats.draw_calls++;
 }
 
 static void gl_swap_buffers(GLFWwindow *window)
@@ -209,16 +320,39 @@ static void gl_destroy_vertex_array(GraphicsVertexArray vao)
   free(vertex_array);
 }
 
-static void gl_set_uniform_mat4(GraphicsProgram program, s32 location, const r32 *data)
+static void gl_set_uniform_int(GraphicsProgram program, UniformHandle handle, s32 data)
 {
-  glUniformMatrix4fv(location, 1, GL_FALSE, data);
+  if (handle == UNIFORM_NONE)
+    return;
+  glUniform1i(handle, data);
 }
 
-static void gl_set_uniform_vec3(GraphicsProgram program, s32 location, const r32 *data)
+static void gl_set_uniform_float(GraphicsProgram program, UniformHandle handle, r32 data)
 {
-  if (location == -1)
+  if (handle == UNIFORM_NONE)
     return;
-  glUniform3fv(location, 1, data);
+  glUniform1f(handle, data);
+}
+
+static void gl_set_uniform_vec3(GraphicsProgram program, UniformHandle handle, const r32 *data)
+{
+  if (handle == UNIFORM_NONE)
+    return;
+  glUniform3fv(handle, 1, data);
+}
+
+static void gl_set_uniform_vec4(GraphicsProgram program, UniformHandle handle, const r32 *data)
+{
+  if (handle == UNIFORM_NONE)
+    return;
+  glUniform4fv(handle, 1, data);
+}
+
+static void gl_set_uniform_mat4(GraphicsProgram program, UniformHandle handle, const r32 *data)
+{
+  if (handle == UNIFORM_NONE)
+    return;
+  glUniformMatrix4fv(handle, 1, GL_FALSE, data);
 }
 
 static void gl_set_int(GraphicsProgram program, const char *name, s32 data)
@@ -271,6 +405,155 @@ static void gl_bind_index_buffer(GraphicsBuffer buffer)
 static void gl_draw_elements(s32 count)
 {
   glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0);
+  s_gl_stats.draw_calls++;
+  s_gl_stats.instances++;
+}
+
+static void gl_draw_elements_instanced(s32 count, s32 instance_count)
+{
+  glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0, instance_count);
+  s_gl_stats.draw_calls++;
+  s_gl_stats.instances += instance_count;
+}
+
+static GraphicsBuffer gl_create_dynamic_buffer(Arena *arena, size_t size)
+{
+  GLBuffer *buffer = (GLBuffer *)push_struct(arena, GLBuffer);
+  glGenBuffers(1, &buffer->id);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer->id);
+  glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+  return buffer;
+}
+
+// (Re)creates the storage for GL_STREAM_REGIONS regions. The old buffer may still be read
+// by queued draws; GL keeps it alive until they finish.
+static void gl_stream_allocate(GLStreamBuffer *stream, size_t region_size)
+{
+  if (stream->id)
+  {
+    if (stream->persistent)
+    {
+      glBindBuffer(GL_ARRAY_BUFFER, stream->id);
+      glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glDeleteBuffers(1, &stream->id);
+  }
+  for (u32 i = 0; i < GL_STREAM_REGIONS; ++i)
+  {
+    if (stream->fences[i])
+      glDeleteSync(stream->fences[i]);
+    stream->fences[i] = nullptr;
+  }
+
+  stream->region_size = region_size;
+  stream->region = 0;
+  stream->in_flight = false;
+  stream->persistent = nullptr;
+
+  size_t total = region_size * GL_STREAM_REGIONS;
+  glGenBuffers(1, &stream->id);
+  glBindBuffer(GL_ARRAY_BUFFER, stream->id);
+#ifdef GL_MAP_PERSISTENT_BIT
+  if (s_gl_buffer_storage)
+  {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_ARRAY_BUFFER, total, nullptr, flags);
+    stream->persistent = (u8 *)glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags);
+    if (stream->persistent)
+      return;
+    fprintf(stderr, "Persistent mapping failed, streaming with per-frame maps\n");
+    glDeleteBuffers(1, &stream->id);
+    glGenBuffers(1, &stream->id);
+    glBindBuffer(GL_ARRAY_BUFFER, stream->id);
+  }
+#endif
+  glBufferData(GL_ARRAY_BUFFER, total, nullptr, GL_STREAM_DRAW);
+}
+
+static GraphicsStreamBuffer gl_create_stream_buffer(Arena *arena, size_t frame_size)
+{
+  GLStreamBuffer *stream = push_struct(arena, GLStreamBuffer);
+  gl_stream_allocate(stream, (frame_size + 255) & ~(size_t)255);
+  return stream;
+}
+
+static void *gl_stream_buffer_begin(GraphicsStreamBuffer buffer, size_t size)
+{
+  GLStreamBuffer *stream = (GLStreamBuffer *)buffer;
+
+  // Everything reading the previous region has been submitted by now
+  if (stream->in_flight)
+  {
+    stream->fences[stream->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    stream->in_flight = false;
+  }
+
+  if (size > stream->region_size)
+  {
+    size_t region_size = stream->region_size;
+    while (region_size < size)
+      region_size *= 2;
+    gl_stream_allocate(stream, region_size);
+    s_gl_stats.stream_grows++;
+  }
+  else
+    stream->region = (stream->region + 1) % GL_STREAM_REGIONS;
+
+  GLsync fence = stream->fences[stream->region];
+  if (fence)
+  {
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+      s_gl_stats.stream_stalls++;
+      while (result == GL_TIMEOUT_EXPIRED)
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+    }
+    glDeleteSync(fence);
+    stream->fences[stream->region] = nullptr;
+  }
+
+  size_t offset = (size_t)stream->region * stream->region_size;
+  if (stream->persistent)
+    stream->mapped = stream->persistent + offset;
+  else
+  {
+    glBindBuffer(GL_ARRAY_BUFFER, stream->id);
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+    stream->mapped = (u8 *)glMapBufferRange(GL_ARRAY_BUFFER, offset, stream->region_size, flags);
+  }
+  return stream->mapped;
+}
+
+static size_t gl_stream_buffer_end(GraphicsStreamBuffer buffer, size_t used)
+{
+  GLStreamBuffer *stream = (GLStreamBuffer *)buffer;
+  size_t offset = (size_t)stream->region * stream->region_size;
+
+  glBindBuffer(GL_ARRAY_BUFFER, stream->id);
+  if (!stream->persistent && stream->mapped)
+  {
+    if (used)
+      glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, used);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+  }
+  stream->mapped = nullptr;
+  stream->in_flight = true;
+  s_gl_stats.stream_bytes += used;
+  return offset;
+}
+
+static void gl_bind_stream_buffer(GraphicsStreamBuffer buffer)
+{
+  GLStreamBuffer *stream = (GLStreamBuffer *)buffer;
+  glBindBuffer(GL_ARRAY_BUFFER, stream->id);
+}
+
+static void gl_read_stats(GraphicsStats *stats, bool reset)
+{
+  *stats = s_gl_stats;
+  if (reset)
+    s_gl_stats = {};
 }
 
 static void opengl_enable_depth_test()
@@ -288,6 +571,15 @@ static void opengl_set_line_width(float width)
   glLineWidth(width);
 }
 
+static void opengl_set_wireframe(bool enabled)
+{
+  glPolygonMode(GL_FRONT_AND_BACK, enabled ? GL_LINE : GL_FILL);
+  if (enabled)
+    glDisable(GL_CULL_FACE);
+  else
+    glEnable(GL_CULL_FACE);
+}
+
 static void opengl_update_buffer_data(GraphicsBuffer buffer, const void *data, size_t size)
 {
   GLBuffer *vbo = (GLBuffer *)buffer;
@@ -296,9 +588,17 @@ static void opengl_update_buffer_data(GraphicsBuffer buffer, const void *data, s
   glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
 }
 
+static void opengl_update_buffer_range(GraphicsBuffer buffer, size_t offset, const void *data, size_t size)
+{
+  GLBuffer *vbo = (GLBuffer *)buffer;
+  glBindBuffer(GL_ARRAY_BUFFER, vbo->id);
+  glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+}
+
 static void gl_draw_line_arrays(s32 first, s32 count)
 {
   glDrawArrays(GL_LINES, first, count);
+  s_gl_stats.draw_calls++;
 }
 
 
@@ -317,6 +617,7 @@ static GraphicsAPI s_opengl_api = {
     .get_uniform_location = gl_get_uniform_location,
     .enable_vertex_attrib = gl_enable_vertex_attrib,
     .vertex_attrib_pointer = gl_vertex_attrib_pointer,
+    .vertex_attrib_format_pointer = gl_vertex_attrib_format_pointer,
     .clear = gl_clear,
     .viewport = gl_viewport,
     .draw_arrays = gl_draw_arrays,
@@ -326,6 +627,10 @@ static GraphicsAPI s_opengl_api = {
     .destroy_program = gl_destroy_program,
     .destroy_vertex_array = gl_destroy_vertex_array,
     .set_window_hints = gl_set_window_hints,
+    .find_uniform = gl_get_uniform_location,
+    .set_uniform_int = gl_set_uniform_int,
+    .set_uniform_float = gl_set_uniform_float,
+    .set_uniform_vec4 = gl_set_uniform_vec4,
     .set_uniform_mat4 = gl_set_uniform_mat4,
     .set_int = gl_set_int,
     .set_float = gl_set_float,
@@ -336,13 +641,23 @@ static GraphicsAPI s_opengl_api = {
     .create_index_buffer = gl_create_index_buffer,
     .bind_index_buffer = gl_bind_index_buffer,
     .draw_elements = gl_draw_elements,
+    .draw_elements_instanced = gl_draw_elements_instanced,
+    .vertex_attrib_divisor = gl_vertex_attrib_divisor,
 
 
     .enable_depth_test = opengl_enable_depth_test,
     .disable_depth_test = opengl_disable_depth_test,
     .set_line_width = opengl_set_line_width,
+    .set_wireframe = opengl_set_wireframe,
     .update_buffer_data = opengl_update_buffer_data,
+    .update_buffer_range = opengl_update_buffer_range,
     .draw_line_arrays = gl_draw_line_arrays,
+    .create_dynamic_buffer = gl_create_dynamic_buffer,
+    .read_stats = gl_read_stats,
+    .create_stream_buffer = gl_create_stream_buffer,
+    .stream_buffer_begin = gl_stream_buffer_begin,
+    .stream_buffer_end = gl_stream_buffer_end,
+    .bind_stream_buffer = gl_bind_stream_buffer,
 };
 
 GraphicsAPI *create_graphics_api_opengl()
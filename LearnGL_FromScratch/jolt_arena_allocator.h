@@ -5,44 +5,116 @@
 #include <Jolt/Core/TempAllocator.h>
 #include "arena2.h"
 
+// Stack allocator for Jolt's temp allocations. Jolt frees in LIFO order, so a free rewinds
+// the top. When the current block is full the allocation moves on to a chained overflow
+// block pushed from the Arena instead of failing; overflow blocks are kept for later steps.
+// The Arena must not be shared with other threads, a step may grow it from any thread.
 class JoltTempArenaAllocator : public JPH::TempAllocator
 {
 public:
   JoltTempArenaAllocator(Arena *arena, size_t temp_size)
       : arena(arena)
   {
-    temp_buffer = (u8 *)arena_push(arena, temp_size, 16, 0); // 16-byte alignment
-    temp_buffer_size = temp_size;
-    temp_buffer_used = 0;
+    first.base = (u8 *)arena_push(arena, temp_size, 16, 0); // 16-byte alignment
+    first.size = temp_size;
+    current = &first;
   }
 
   virtual void *Allocate(uint inSize) override
   {
-    // Align to 16 bytes
-    inSize = (inSize + 15) & ~15;
-    if (temp_buffer_used + inSize > temp_buffer_size)
-    {
-      JPH_ASSERT(false, "TempAllocator out of memory!");
+    if (inSize == 0)
       return nullptr;
-    }
 
-    void *result = temp_buffer + temp_buffer_used;
-    temp_buffer_used += inSize;
+    // Align to 16 bytes
+    size_t size = (inSize + 15) & ~(size_t)15;
+    if (current->used + size > current->size)
+      current = next_block(size);
+
+    void *result = current->base + current->used;
+    current->used += size;
+    in_use += size;
+    if (in_use > step_peak)
+      step_peak = in_use;
     return result;
   }
 
-  virtual void Free(void *inAddress, uint inSize) override {}
+  virtual void Free(void *inAddress, uint inSize) override
+  {
+    if (inAddress == nullptr)
+      return;
+
+    size_t size = (inSize + 15) & ~(size_t)15;
+    JPH_ASSERT((u8 *)inAddress + size == current->base + current->used, "TempAllocator free is not LIFO");
+    current->used -= size;
+    in_use -= size;
+
+    // Step back out of drained overflow blocks, earlier blocks keep their (full) tails
+    while (current->used == 0 && current->prev)
+      current = current->prev;
+  }
 
+  // Called before each step. Everything should already be freed; the step's peak is kept
   void Clear()
   {
-    temp_buffer_used = 0;
+    JPH_ASSERT(in_use == 0, "TempAllocator has live allocations");
+    for (Block *block = &first; block; block = block->next)
+      block->used = 0;
+    current = &first;
+    in_use = 0;
+
+    last_step_peak = step_peak;
+    if (step_peak > peak)
+      peak = step_peak;
+    step_peak = 0;
   }
 
+  size_t get_capacity() const { return first.size; }
+  size_t get_peak() const { return step_peak > peak ? step_peak : peak; } // high-water mark over all steps
+  size_t get_last_step_peak() const { return last_step_peak; }
+  size_t get_overflow_bytes() const { return overflow_bytes; } // pushed from the Arena beyond temp_size
+  u32 get_overflow_blocks() const { return overflow_blocks; }
+
 private:
+  struct Block
+  {
+    u8 *base = nullptr;
+    size_t size = 0;
+    size_t used = 0;
+    Block *prev = nullptr;
+    Block *next = nullptr;
+  };
+
+  // Reuses the following block if it fits, otherwise splices a new one in after current
+  Block *next_block(size_t size)
+  {
+    Block *next = current->next;
+    if (next && next->size >= size)
+      return next;
+
+    size_t block_size = first.size / 2 > size ? first.size / 2 : size;
+    Block *block = push_struct(arena, Block);
+    block->base = (u8 *)arena_push(arena, block_size, 16, 0);
+    block->size = block_size;
+    block->prev = current;
+    block->next = next;
+    if (next)
+      next->prev = block;
+    current->next = block;
+
+    overflow_bytes += block_size;
+    overflow_blocks++;
+    return block;
+  }
+
   Arena *arena;
-  u8 *temp_buffer;
-  size_t temp_buffer_size;
-  size_t temp_buffer_used;
+  Block first;
+  Block *current;
+  size_t in_use = 0;
+  size_t step_peak = 0;
+  size_t last_step_peak = 0;
+  size_t peak = 0;
+  size_t overflow_bytes = 0;
+  u32 overflow_blocks = 0;
 };
 
 #endif // JOLT_ARENA_ALLOCATOR_H
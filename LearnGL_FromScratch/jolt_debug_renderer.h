@@ -0,0 +1,326 @@
+// jolt_debug_renderer.h
+#ifndef JOLT_DEBUG_RENDERER_H
+#define JOLT_DEBUG_RENDERER_H
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Renderer/DebugRenderer.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include "graphics_api.h"
+#include "linmath.h"
+#include "arena2.h"
+
+struct Mesh;
+
+#define JOLT_DEBUG_BLOCK_BYTES KB(256)
+
+// Chained storage pushed from a chunk's arena, items follow the header
+struct JoltDebugBlock
+{
+  JoltDebugBlock *next;
+  u32 count;
+  u32 capacity;
+};
+static_assert(sizeof(JoltDebugBlock) == 16, "block items must stay 16-byte aligned");
+
+struct JoltDebugBlockList
+{
+  JoltDebugBlock *first;
+  JoltDebugBlock *last;
+  u32 count; // items over all blocks
+};
+
+// One thread's output while debug drawing runs on the job system. Reset every frame.
+struct JoltDebugChunk
+{
+  Arena *arena;
+  Temp frame; // start of the arena, rewound by jolt_debug_chunk_reset
+  JoltDebugBlockList lines;     // JoltDebugRenderer::Vertex
+  JoltDebugBlockList instances; // JoltDebugRenderer::InstanceRecord
+  JoltDebugBlockList deferred;  // u32 caller-defined items (bodies to draw on the calling thread)
+};
+
+inline void *jolt_debug_block_push(Arena *arena, JoltDebugBlockList *list, u32 item_size, u32 count)
+{
+  JoltDebugBlock *block = list->last;
+  if (!block || block->count + count > block->capacity)
+  {
+    u32 capacity = JOLT_DEBUG_BLOCK_BYTES / item_size;
+    JoltDebugBlock *next = (JoltDebugBlock *)arena_push(arena, sizeof(JoltDebugBlock) + (size_t)capacity * item_size, 16, 0);
+    next->next = nullptr;
+    next->count = 0;
+    next->capacity = capacity;
+    if (block)
+      block->next = next;
+    else
+      list->first = next;
+    list->last = block = next;
+  }
+  void *result = (u8 *)(block + 1) + (size_t)block->count * item_size;
+  block->count += count;
+  list->count += count;
+  return result;
+}
+
+inline void jolt_debug_chunk_reset(JoltDebugChunk *chunk)
+{
+  temp_end(chunk->frame);
+  chunk->lines = {};
+  chunk->instances = {};
+  chunk->deferred = {};
+}
+
+// Triangle geometry handed to Jolt by CreateTriangleBatch. Shapes keep the returned batch in
+// their own geometry cache, so each one is converted once and uploaded once (lazily, as a
+// Mesh on the render thread). Batches are owned by the renderer and live as long as it does.
+class JoltDebugBatch final : public JPH::RefTargetVirtual
+{
+public:
+  virtual void AddRef() override { refs.fetch_add(1, std::memory_order_relaxed); }
+  virtual void Release() override { refs.fetch_sub(1, std::memory_order_relaxed); }
+
+  std::atomic<u32> refs{0};
+  u32 index; // into JoltDebugRenderer::batches
+
+  // CPU copy in Mesh stream layout until the upload
+  r32 *positions;
+  r32 *normals;
+  r32 *colors;
+  u32 *indices;
+  s32 vertex_count;
+  s32 index_count;
+  Mesh *mesh; // nullptr until uploaded
+};
+
+// Full JPH::DebugRenderer. Lines (and triangles, drawn as outlines) are written straight into
+// the caller's vertex memory, see BeginLines; vertex_count keeps counting past the capacity so
+// the caller can size the next frame. DrawGeometry only records an instance per call, the
+// caller draws every batch instanced once per frame and draw mode.
+//
+// A thread that sets tls_chunk (one of chunks) writes lines and instances into that chunk
+// instead, so several threads can draw at once. Instances always go to a chunk, chunks[0]
+// when none is set.
+class JoltDebugRenderer final : public JPH::DebugRenderer
+{
+public:
+  // Color is RGBA8 in memory order (JPH::Color), normalized on fetch
+  struct Vertex
+  {
+    r32 pos[3];
+    u32 color;
+  };
+  static_assert(sizeof(Vertex) == 16, "debug vertex must stay one SIMD register");
+
+  struct Instance
+  {
+    r32 model[16];
+    u32 color; // RGBA8
+  };
+
+  struct InstanceRecord
+  {
+    Instance instance;
+    u32 key; // batch index * DRAW_MODE_COUNT + mode
+  };
+
+  enum DrawMode : u32
+  {
+    DRAW_SOLID = 0,
+    DRAW_WIREFRAME,
+    DRAW_MODE_COUNT,
+  };
+
+  // chunk_count: threads that may draw at once (job workers + the caller)
+  JoltDebugRenderer(Arena *arena, u32 chunk_count) : arena(arena), chunk_count(chunk_count)
+  {
+    chunks = push_array(arena, JoltDebugChunk, chunk_count);
+    for (u32 i = 0; i < chunk_count; ++i)
+    {
+      chunks[i].arena = arena_alloc(GB(4), KB(64), 0);
+      chunks[i].frame = temp_begin(chunks[i].arena);
+    }
+    Initialize();
+  }
+
+  static inline thread_local JoltDebugChunk *tls_chunk = nullptr;
+
+  void BeginLines(Vertex *target, s32 capacity)
+  {
+    vertices = target;
+    vertex_capacity = target ? capacity : 0;
+    vertex_count = 0;
+  }
+
+  // Clears last frame's chunks, camera_pos picks the LODs
+  void BeginGeometry(const r32 *camera_pos)
+  {
+    camera = JPH::Vec3(camera_pos[0], camera_pos[1], camera_pos[2]);
+    for (u32 i = 0; i < chunk_count; ++i)
+      jolt_debug_chunk_reset(&chunks[i]);
+  }
+
+  // Instances over all chunks
+  u32 instance_count() const
+  {
+    u32 count = 0;
+    for (u32 i = 0; i < chunk_count; ++i)
+      count += chunks[i].instances.count;
+    return count;
+  }
+
+  // Line vertices written to chunks (not into the BeginLines target)
+  u32 chunk_vertex_count() const
+  {
+    u32 count = 0;
+    for (u32 i = 0; i < chunk_count; ++i)
+      count += chunks[i].lines.count;
+    return count;
+  }
+
+  // Vertices actually written
+  s32 written_count() const { return vertex_count < vertex_capacity ? vertex_count : vertex_capacity; }
+
+  virtual void DrawLine(JPH::RVec3Arg inFrom, JPH::RVec3Arg inTo, JPH::ColorArg inColor) override
+  {
+    Vertex *out;
+    if (JoltDebugChunk *chunk = tls_chunk)
+      out = (Vertex *)jolt_debug_block_push(chunk->arena, &chunk->lines, sizeof(Vertex), 2);
+    else
+    {
+      s32 index = vertex_count;
+      vertex_count += 2;
+      if (index + 2 > vertex_capacity)
+        return;
+      out = &vertices[index];
+    }
+
+    // One 16-byte store per endpoint, the color rides in w
+    r32 color = JPH::BitCast<r32>(inColor.GetUInt32());
+    JPH::Vec4(JPH::Vec3(inFrom), color).StoreFloat4((JPH::Float4 *)&out[0]);
+    JPH::Vec4(JPH::Vec3(inTo), color).StoreFloat4((JPH::Float4 *)&out[1]);
+  }
+
+  virtual void DrawTriangle(JPH::RVec3Arg inV1, JPH::RVec3Arg inV2, JPH::RVec3Arg inV3, JPH::ColorArg inColor,
+                            ECastShadow inCastShadow = ECastShadow::Off) override
+  {
+    DrawLine(inV1, inV2, inColor);
+    DrawLine(inV2, inV3, inColor);
+    DrawLine(inV3, inV1, inColor);
+  }
+
+  virtual Batch CreateTriangleBatch(const Triangle *inTriangles, int inTriangleCount) override
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    JoltDebugBatch *batch = push_batch(inTriangleCount * 3, inTriangleCount * 3);
+    for (s32 i = 0; i < batch->vertex_count; ++i)
+    {
+      write_vertex(batch, i, inTriangles[i / 3].mV[i % 3]);
+      batch->indices[i] = (u32)i;
+    }
+    return batch;
+  }
+
+  virtual Batch CreateTriangleBatch(const JPH::DebugRenderer::Vertex *inVertices, int inVertexCount,
+                                    const JPH::uint32 *inIndices, int inIndexCount) override
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    JoltDebugBatch *batch = push_batch(inVertexCount, inIndexCount);
+    for (s32 i = 0; i < inVertexCount; ++i)
+      write_vertex(batch, i, inVertices[i]);
+    memcpy(batch->indices, inIndices, inIndexCount * sizeof(u32));
+    return batch;
+  }
+
+  // Solid geometry uses the global back-face culling, wireframe is drawn with culling off
+  virtual void DrawGeometry(JPH::RMat44Arg inModelMatrix, const JPH::AABox &inWorldSpaceBounds, float inLODScaleSq,
+                            JPH::ColorArg inModelColor, const GeometryRef &inGeometry, ECullMode inCullMode,
+                            ECastShadow inCastShadow, EDrawMode inDrawMode) override
+  {
+    const JPH::Array<LOD> &lods = inGeometry->mLODs;
+    if (lods.empty())
+      return;
+
+    // First LOD whose switch distance covers the bounds, the coarsest one beyond all of them
+    const LOD *lod = &lods.back();
+    r32 distance_sq = inWorldSpaceBounds.GetSqDistanceTo(camera);
+    for (const LOD &candidate : lods)
+      if (distance_sq <= inLODScaleSq * candidate.mDistance * candidate.mDistance)
+      {
+        lod = &candidate;
+        break;
+      }
+
+    JoltDebugBatch *batch = (JoltDebugBatch *)lod->mTriangleBatch.GetPtr();
+    if (!batch || batch->index_count == 0)
+      return;
+
+    JoltDebugChunk *chunk = tls_chunk ? tls_chunk : &chunks[0];
+    InstanceRecord *record = (InstanceRecord *)jolt_debug_block_push(chunk->arena, &chunk->instances, sizeof(InstanceRecord), 1);
+    record->key = batch->index * DRAW_MODE_COUNT + (inDrawMode == EDrawMode::Wireframe ? DRAW_WIREFRAME : DRAW_SOLID);
+#ifdef JPH_DOUBLE_PRECISION
+    inModelMatrix.ToMat44().StoreFloat4x4((JPH::Float4 *)record->instance.model);
+#else
+    inModelMatrix.StoreFloat4x4((JPH::Float4 *)record->instance.model);
+#endif
+    record->instance.color = inModelColor.GetUInt32();
+  }
+
+  virtual void DrawText3D(JPH::RVec3Arg inPosition, const std::string_view &inString, JPH::ColorArg inColor, r32 inHeight) override {}
+
+  Arena *arena; // batches, CreateTriangleBatch takes the lock
+  std::mutex lock;
+  JoltDebugChunk *chunks;
+  u32 chunk_count;
+
+  Vertex *vertices = nullptr;
+  s32 vertex_count = 0;
+  s32 vertex_capacity = 0;
+
+  JoltDebugBatch **batches = nullptr;
+  u32 batch_count = 0;
+  u32 batch_capacity = 0;
+
+  JPH::Vec3 camera = JPH::Vec3::sZero();
+
+private:
+  JoltDebugBatch *push_batch(s32 vertex_count, s32 index_count)
+  {
+    if (batch_count == batch_capacity)
+    {
+      u32 capacity = batch_capacity ? batch_capacity * 2 : 64;
+      JoltDebugBatch **grown = push_array_no_zero(arena, JoltDebugBatch *, capacity);
+      if (batch_count)
+        memcpy(grown, batches, batch_count * sizeof(JoltDebugBatch *));
+      batches = grown;
+      batch_capacity = capacity;
+    }
+
+    JoltDebugBatch *batch = new (push_struct(arena, JoltDebugBatch)) JoltDebugBatch();
+    batch->index = batch_count;
+    batch->positions = push_array_no_zero(arena, r32, 3 * vertex_count);
+    batch->normals = push_array_no_zero(arena, r32, 3 * vertex_count);
+    batch->colors = push_array_no_zero(arena, r32, 3 * vertex_count);
+    batch->indices = push_array_no_zero(arena, u32, index_count);
+    batch->vertex_count = vertex_count;
+    batch->index_count = index_count;
+    batch->mesh = nullptr;
+    batches[batch_count++] = batch;
+    return batch;
+  }
+
+  static void write_vertex(JoltDebugBatch *batch, s32 i, const JPH::DebugRenderer::Vertex &vertex)
+  {
+    batch->positions[3 * i + 0] = vertex.mPosition.x;
+    batch->positions[3 * i + 1] = vertex.mPosition.y;
+    batch->positions[3 * i + 2] = vertex.mPosition.z;
+    batch->normals[3 * i + 0] = vertex.mNormal.x;
+    batch->normals[3 * i + 1] = vertex.mNormal.y;
+    batch->normals[3 * i + 2] = vertex.mNormal.z;
+    batch->colors[3 * i + 0] = vertex.mColor.r / 255.0f;
+    batch->colors[3 * i + 1] = vertex.mColor.g / 255.0f;
+    batch->colors[3 * i + 2] = vertex.mColor.b / 255.0f;
+  }
+};
+
+#endif // JOLT_DEBUG_RENDERER_H
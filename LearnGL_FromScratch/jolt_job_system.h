@@ -0,0 +1,373 @@
+#ifndef JOLT_JOB_SYSTEM_H
+#define JOLT_JOB_SYSTEM_H
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/Semaphore.h>
+#include <Jolt/Core/Profiler.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "arena2.h"
+#include "profiler.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Extra barriers on top of what the physics step needs, for game tasks running at the same time
+#define JOB_SYSTEM_GAME_BARRIERS 8
+
+// Worker placement. Cores are logical CPU indices, -1 leaves the OS default.
+struct JobThreadConfig
+{
+  s32 first_core = -1;    // worker i is pinned to the i-th core from here, skipping reserved_core
+  s32 reserved_core = -1; // kept free of workers, the creating (main/render) thread is pinned to it
+  s32 nice = 0;           // worker nice value, negative needs CAP_SYS_NICE
+};
+
+struct JobWorkerStats
+{
+  r64 busy_fraction; // time spent running jobs since the last reset
+  u64 jobs;
+  u64 steals;
+  s32 core; // -1 when not pinned
+};
+
+// Pinning and priority are only implemented for Linux; elsewhere they are reported and ignored
+inline bool job_thread_pin(s32 core)
+{
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+inline bool job_thread_set_nice(s32 nice)
+{
+#if defined(__linux__)
+  return setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice) == 0;
+#else
+  return false;
+#endif
+}
+
+// One pool for Jolt and game code. Every worker owns a deque: it pushes and pops at the back
+// (LIFO, the job it just spawned is still in cache) and steals from the front of the others
+// when it runs dry. Jobs queued from outside the pool are spread round-robin.
+class JobSystemWorkStealing final : public JPH::JobSystemWithBarrier
+{
+public:
+  JobSystemWorkStealing(Arena *arena, u32 max_jobs, u32 max_barriers, s32 num_threads, JobThreadConfig thread_config = {})
+      : JPH::JobSystemWithBarrier(max_barriers + JOB_SYSTEM_GAME_BARRIERS), thread_config(thread_config)
+  {
+    if (thread_config.reserved_core >= 0 && !job_thread_pin(thread_config.reserved_core))
+      fprintf(stderr, "Job system: could not pin main thread to core %d\n", thread_config.reserved_core);
+
+    jobs.Init(max_jobs, max_jobs);
+
+    worker_count = num_threads > 0 ? (u32)num_threads : 0;
+    if (worker_count == 0)
+      return; // barriers run every job on the waiting thread
+
+    u32 capacity = 1;
+    while (capacity < max_jobs)
+      capacity <<= 1;
+    workers = push_array(arena, Worker, worker_count);
+    for (u32 i = 0; i < worker_count; ++i)
+    {
+      new (&workers[i]) Worker();
+      workers[i].ring = push_array(arena, Job *, capacity);
+      workers[i].mask = capacity - 1;
+      workers[i].core = worker_core(i);
+    }
+
+    stats_start = std::chrono::steady_clock::now();
+    running = true;
+    for (u32 i = 0; i < worker_count; ++i)
+      workers[i].thread = std::thread([this, i]() { worker_main(i); });
+  }
+
+  virtual ~JobSystemWorkStealing() override
+  {
+    running = false;
+    if (worker_count)
+      semaphore.Release(worker_count);
+    for (u32 i = 0; i < worker_count; ++i)
+    {
+      workers[i].thread.join();
+      while (Job *job = pop_back(i))
+        job->Release();
+      workers[i].~Worker();
+    }
+  }
+
+  virtual int GetMaxConcurrency() const override
+  {
+    return (int)worker_count + 1;
+  }
+
+  virtual JobHandle CreateJob(const char *name, JPH::ColorArg color, const JobFunction &function, JPH::uint32 num_dependencies = 0) override
+  {
+    JPH::uint32 index;
+    for (;;)
+    {
+      index = jobs.ConstructObject(name, color, this, function, num_dependencies);
+      if (index != AvailableJobs::cInvalidObjectIndex)
+        break;
+      JPH_ASSERT(false, "No jobs available!");
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    Job *job = &jobs.Get(index);
+
+    // Take the handle first, the job may complete as soon as it is queued
+    JobHandle handle(job);
+    if (num_dependencies == 0)
+      QueueJob(job);
+    return handle;
+  }
+
+  // Game task API -----------------------------------------------------------------------
+
+  // Fire-and-forget job, pair with a Barrier (CreateBarrier/AddJob/WaitForJobs) to join
+  JobHandle run(const char *name, const JobFunction &function)
+  {
+    return CreateJob(name, JPH::Color::sGrey, function);
+  }
+
+  // Runs fn(begin, end) over [0, count) in grain-sized ranges and waits for all of them.
+  // The calling thread takes part, so this is safe to call from inside a job.
+  template <typename F>
+  void parallel_for(const char *name, u32 count, u32 grain, const F &fn)
+  {
+    if (count == 0)
+      return;
+    PROFILE_SCOPE(name);
+    if (worker_count == 0 || count <= grain)
+    {
+      fn(0u, count);
+      return;
+    }
+
+    Barrier *barrier = CreateBarrier();
+    for (u32 begin = 0; begin < count; begin += grain)
+    {
+      u32 end = begin + grain < count ? begin + grain : count;
+      barrier->AddJob(CreateJob(name, JPH::Color::sGrey, [&fn, begin, end]() { fn(begin, end); }));
+    }
+    WaitForJobs(barrier);
+    DestroyBarrier(barrier);
+  }
+
+  u32 get_worker_count() const { return worker_count; }
+
+  // 1 + worker index on one of this pool's workers, 0 on any other thread (the caller of
+  // parallel_for included). Indexes per-thread scratch sized get_worker_count() + 1.
+  u32 thread_slot() const { return tls_pool == this ? tls_worker + 1 : 0; }
+
+  void reset_worker_stats()
+  {
+    for (u32 i = 0; i < worker_count; ++i)
+    {
+      workers[i].busy_ns = 0;
+      workers[i].jobs = 0;
+      workers[i].steals = 0;
+    }
+    stats_start = std::chrono::steady_clock::now();
+  }
+
+  // Fills up to max_count workers, returns how many. Counters restart when reset is set.
+  u32 read_worker_stats(JobWorkerStats *out, u32 max_count, bool reset)
+  {
+    auto now = std::chrono::steady_clock::now();
+    r64 wall_ns = (r64)std::chrono::duration_cast<std::chrono::nanoseconds>(now - stats_start).count();
+    u32 count = worker_count < max_count ? worker_count : max_count;
+    for (u32 i = 0; i < count; ++i)
+    {
+      Worker *worker = &workers[i];
+      u64 busy = reset ? worker->busy_ns.exchange(0) : worker->busy_ns.load();
+      out[i].busy_fraction = wall_ns > 0.0 ? busy / wall_ns : 0.0;
+      out[i].jobs = reset ? worker->jobs.exchange(0) : worker->jobs.load();
+      out[i].steals = reset ? worker->steals.exchange(0) : worker->steals.load();
+      out[i].core = worker->core;
+    }
+    if (reset)
+      stats_start = now;
+    return count;
+  }
+
+protected:
+  virtual void QueueJob(Job *job) override
+  {
+    if (worker_count == 0)
+      return;
+    job->AddRef();
+    push_back(target_worker(), job);
+    semaphore.Release();
+  }
+
+  virtual void QueueJobs(Job **queued, JPH::uint count) override
+  {
+    if (worker_count == 0 || count == 0)
+      return;
+    u32 w = target_worker();
+    for (JPH::uint i = 0; i < count; ++i)
+    {
+      queued[i]->AddRef();
+      push_back(w, queued[i]);
+    }
+    semaphore.Release(count < worker_count ? count : worker_count);
+  }
+
+  virtual void FreeJob(Job *job) override
+  {
+    jobs.DestroyObject(job);
+  }
+
+private:
+  using AvailableJobs = JPH::FixedSizeFreeList<Job>;
+
+  struct Worker
+  {
+    std::mutex lock;
+    Job **ring;
+    u32 mask;
+    u32 head = 0; // steal end
+    u32 tail = 0; // owner end
+    std::thread thread;
+    s32 core = -1;
+    std::atomic<u64> busy_ns{0};
+    std::atomic<u64> jobs{0};
+    std::atomic<u64> steals{0};
+  };
+
+  static inline thread_local const JobSystemWorkStealing *tls_pool = nullptr;
+  static inline thread_local u32 tls_worker = 0;
+
+  u32 target_worker()
+  {
+    if (tls_pool == this)
+      return tls_worker;
+    return next_worker.fetch_add(1, std::memory_order_relaxed) % worker_count;
+  }
+
+  void push_back(u32 w, Job *job)
+  {
+    Worker *worker = &workers[w];
+    std::lock_guard<std::mutex> guard(worker->lock);
+    JPH_ASSERT(worker->tail - worker->head <= worker->mask, "Worker deque full");
+    worker->ring[worker->tail++ & worker->mask] = job;
+  }
+
+  Job *pop_back(u32 w)
+  {
+    Worker *worker = &workers[w];
+    std::lock_guard<std::mutex> guard(worker->lock);
+    if (worker->tail == worker->head)
+      return nullptr;
+    return worker->ring[--worker->tail & worker->mask];
+  }
+
+  Job *steal_front(u32 w)
+  {
+    Worker *worker = &workers[w];
+    std::lock_guard<std::mutex> guard(worker->lock);
+    if (worker->tail == worker->head)
+      return nullptr;
+    return worker->ring[worker->head++ & worker->mask];
+  }
+
+  Job *find_job(u32 self)
+  {
+    if (Job *job = pop_back(self))
+      return job;
+    for (u32 k = 1; k < worker_count; ++k)
+    {
+      if (Job *job = steal_front((self + k) % worker_count))
+      {
+        workers[self].steals.fetch_add(1, std::memory_order_relaxed);
+        return job;
+      }
+    }
+    return nullptr;
+  }
+
+  s32 worker_core(u32 i) const
+  {
+    if (thread_config.first_core < 0)
+      return -1;
+    u32 cores = std::thread::hardware_concurrency();
+    if (cores == 0)
+      return -1;
+    s32 core = thread_config.first_core;
+    for (u32 n = 0;; ++core)
+    {
+      if (core % (s32)cores == thread_config.reserved_core && cores > 1)
+        continue;
+      if (n++ == i)
+        return core % (s32)cores;
+    }
+  }
+
+  void worker_main(u32 self)
+  {
+    tls_pool = this;
+    tls_worker = self;
+    JPH_PROFILE_THREAD_START("Worker");
+    profiler_set_thread_name("worker");
+
+    Worker *worker = &workers[self];
+    if (worker->core >= 0 && !job_thread_pin(worker->core))
+      fprintf(stderr, "Job system: could not pin worker %u to core %d\n", self, worker->core);
+    if (thread_config.nice != 0 && !job_thread_set_nice(thread_config.nice))
+      fprintf(stderr, "Job system: could not set worker %u nice to %d\n", self, thread_config.nice);
+
+    while (running)
+    {
+      Job *job = find_job(self);
+      if (!job)
+      {
+        semaphore.Acquire();
+        continue;
+      }
+      // A barrier may already have run it on its waiting thread, Execute is then a no-op
+      auto start = std::chrono::steady_clock::now();
+      {
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+        PROFILE_SCOPE(job->GetName());
+#else
+        PROFILE_SCOPE("job");
+#endif
+        job->Execute();
+      }
+      job->Release();
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      worker->busy_ns.fetch_add((u64)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+      worker->jobs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    JPH_PROFILE_THREAD_END();
+  }
+
+  AvailableJobs jobs;
+  JobThreadConfig thread_config;
+  std::chrono::steady_clock::time_point stats_start;
+  Worker *workers = nullptr;
+  u32 worker_count = 0;
+  std::atomic<u32> next_worker{0};
+  std::atomic<bool> running{false};
+  JPH::Semaphore semaphore;
+};
+
+#endif // JOLT_JOB_SYSTEM_H
@@ -0,0 +1,299 @@
+#ifndef JOLT_POOL_ALLOCATOR_H
+#define JOLT_POOL_ALLOCATOR_H
+
+#include <Jolt/Jolt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include "arena2.h"
+
+// Jolt's global Allocate/Reallocate/Free/AlignedAllocate/AlignedFree routed to size-class
+// pools. Blocks are carved from a dedicated Arena (the game arena is not thread safe) and
+// recycled through per-class free lists; each thread keeps a small cache per class so the
+// job threads rarely touch the shared lists. Anything above the largest class goes to malloc.
+//
+// Every block starts with a 16-byte header in front of the returned pointer, which is how
+// Free finds the class without a size. Alloc/free counts are kept per thread and summed by
+// jolt_pool_read_stats, so the hot path touches no shared cache line.
+
+#define JOLT_POOL_MIN_SHIFT 5  // 32-byte blocks (16 usable)
+#define JOLT_POOL_MAX_SHIFT 14 // 16 KB blocks
+#define JOLT_POOL_CLASSES (JOLT_POOL_MAX_SHIFT - JOLT_POOL_MIN_SHIFT + 1)
+#define JOLT_POOL_LARGE 0xffffffffu
+#define JOLT_POOL_CHUNK KB(64)
+#define JOLT_POOL_CACHE_MAX 64 // per thread and class, half is returned when exceeded
+#define JOLT_POOL_MAX_THREADS 128 // threads beyond this still allocate, but are not counted
+
+struct JoltPoolHeader
+{
+  u32 size_class; // JOLT_POOL_LARGE for malloc'ed blocks
+  u32 offset;     // user pointer - block start
+  u64 size;       // requested size
+};
+static_assert(sizeof(JoltPoolHeader) == 16, "pool header must keep 16-byte alignment");
+
+struct JoltPoolClassStats
+{
+  u32 block_size;
+  u64 allocs;
+  u64 frees;
+  u64 reserved_bytes; // carved from the arena for this class
+};
+
+struct JoltPoolStats
+{
+  JoltPoolClassStats classes[JOLT_POOL_CLASSES];
+  u64 large_allocs;
+  u64 large_frees;
+  u64 large_live_bytes;
+  u64 reserved_bytes; // arena bytes committed to pools
+};
+
+// One cache line per class, threads refilling different classes do not share lines
+struct alignas(64) JoltPoolClass
+{
+  std::mutex lock;
+  void *free_list;
+  std::atomic<u64> reserved_bytes;
+};
+
+// Pushed from the pool arena on a thread's first allocation, lives for the process so the
+// counts of exited threads stay readable
+struct alignas(64) JoltPoolThreadCache
+{
+  void *head[JOLT_POOL_CLASSES];
+  u32 count[JOLT_POOL_CLASSES];
+  std::atomic<u64> allocs[JOLT_POOL_CLASSES]; // only the owning thread stores
+  std::atomic<u64> frees[JOLT_POOL_CLASSES];
+};
+
+struct JoltPool
+{
+  Arena *arena; // only touched under refill_lock
+  std::mutex refill_lock;
+  JoltPoolClass classes[JOLT_POOL_CLASSES];
+  JoltPoolThreadCache *threads[JOLT_POOL_MAX_THREADS]; // registered under refill_lock
+  std::atomic<u32> thread_count;
+  std::atomic<u64> large_allocs;
+  std::atomic<u64> large_frees;
+  std::atomic<u64> large_live_bytes;
+};
+
+inline JoltPool g_jolt_pool;
+inline thread_local JoltPoolThreadCache *tls_jolt_pool_cache;
+
+inline JoltPoolThreadCache *jolt_pool_thread_cache()
+{
+  if (tls_jolt_pool_cache)
+    return tls_jolt_pool_cache;
+
+  std::lock_guard<std::mutex> guard(g_jolt_pool.refill_lock);
+  JoltPoolThreadCache *cache = new (push_struct(g_jolt_pool.arena, JoltPoolThreadCache)) JoltPoolThreadCache();
+  u32 index = g_jolt_pool.thread_count.load(std::memory_order_relaxed);
+  if (index < JOLT_POOL_MAX_THREADS)
+  {
+    g_jolt_pool.threads[index] = cache;
+    g_jolt_pool.thread_count.store(index + 1, std::memory_order_release);
+  }
+  tls_jolt_pool_cache = cache;
+  return cache;
+}
+
+// Single writer, a plain load/store instead of a locked add
+inline void jolt_pool_count(std::atomic<u64> *counter)
+{
+  counter->store(counter->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+inline u32 jolt_pool_class_for(size_t block_size)
+{
+  u32 shift = JOLT_POOL_MIN_SHIFT;
+  while (((size_t)1 << shift) < block_size)
+    shift++;
+  return shift - JOLT_POOL_MIN_SHIFT;
+}
+
+inline size_t jolt_pool_block_size(u32 size_class)
+{
+  return (size_t)1 << (size_class + JOLT_POOL_MIN_SHIFT);
+}
+
+// Takes the class lock, carves a new chunk when the shared list is empty
+inline void jolt_pool_refill(u32 size_class, JoltPoolThreadCache *cache)
+{
+  JoltPoolClass *pool_class = &g_jolt_pool.classes[size_class];
+  size_t block_size = jolt_pool_block_size(size_class);
+  std::lock_guard<std::mutex> guard(pool_class->lock);
+
+  if (!pool_class->free_list)
+  {
+    u8 *chunk;
+    {
+      std::lock_guard<std::mutex> refill_guard(g_jolt_pool.refill_lock);
+      chunk = (u8 *)arena_push(g_jolt_pool.arena, JOLT_POOL_CHUNK, 16, 0);
+    }
+    for (size_t offset = 0; offset + block_size <= JOLT_POOL_CHUNK; offset += block_size)
+    {
+      *(void **)(chunk + offset) = pool_class->free_list;
+      pool_class->free_list = chunk + offset;
+    }
+    pool_class->reserved_bytes.fetch_add(JOLT_POOL_CHUNK, std::memory_order_relaxed);
+  }
+
+  // Move half a cache worth over so the next few allocations stay thread local
+  for (u32 i = 0; i < JOLT_POOL_CACHE_MAX / 2 && pool_class->free_list; ++i)
+  {
+    void *block = pool_class->free_list;
+    pool_class->free_list = *(void **)block;
+    *(void **)block = cache->head[size_class];
+    cache->head[size_class] = block;
+    cache->count[size_class]++;
+  }
+}
+
+inline void *jolt_pool_wrap(u8 *block, u32 size_class, size_t size, size_t alignment)
+{
+  u64 start = (u64)(block + sizeof(JoltPoolHeader));
+  u8 *user = (u8 *)((start + alignment - 1) & ~(u64)(alignment - 1));
+  JoltPoolHeader *header = (JoltPoolHeader *)user - 1;
+  header->size_class = size_class;
+  header->offset = (u32)(user - block);
+  header->size = size;
+  return user;
+}
+
+inline void *jolt_pool_aligned_allocate(size_t size, size_t alignment)
+{
+  if (alignment < 16)
+    alignment = 16;
+  size_t block_size = size + sizeof(JoltPoolHeader) + (alignment - 16);
+
+  if (block_size > jolt_pool_block_size(JOLT_POOL_CLASSES - 1))
+  {
+    u8 *block = (u8 *)malloc(block_size + 16);
+    if (!block)
+      return nullptr;
+    g_jolt_pool.large_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_jolt_pool.large_live_bytes.fetch_add(size, std::memory_order_relaxed);
+    return jolt_pool_wrap(block, JOLT_POOL_LARGE, size, alignment);
+  }
+
+  u32 size_class = jolt_pool_class_for(block_size);
+  JoltPoolThreadCache *cache = jolt_pool_thread_cache();
+  if (!cache->head[size_class])
+    jolt_pool_refill(size_class, cache);
+
+  u8 *block = (u8 *)cache->head[size_class];
+  cache->head[size_class] = *(void **)block;
+  cache->count[size_class]--;
+  jolt_pool_count(&cache->allocs[size_class]);
+  return jolt_pool_wrap(block, size_class, size, alignment);
+}
+
+inline void jolt_pool_free(void *ptr)
+{
+  if (!ptr)
+    return;
+
+  JoltPoolHeader *header = (JoltPoolHeader *)ptr - 1;
+  u8 *block = (u8 *)ptr - header->offset;
+  if (header->size_class == JOLT_POOL_LARGE)
+  {
+    g_jolt_pool.large_frees.fetch_add(1, std::memory_order_relaxed);
+    g_jolt_pool.large_live_bytes.fetch_sub(header->size, std::memory_order_relaxed);
+    free(block);
+    return;
+  }
+
+  u32 size_class = header->size_class;
+  JoltPoolThreadCache *cache = jolt_pool_thread_cache();
+  *(void **)block = cache->head[size_class];
+  cache->head[size_class] = block;
+  cache->count[size_class]++;
+  jolt_pool_count(&cache->frees[size_class]);
+
+  if (cache->count[size_class] > JOLT_POOL_CACHE_MAX)
+  {
+    JoltPoolClass *pool_class = &g_jolt_pool.classes[size_class];
+    std::lock_guard<std::mutex> guard(pool_class->lock);
+    for (u32 i = 0; i < JOLT_POOL_CACHE_MAX / 2; ++i)
+    {
+      void *spill = cache->head[size_class];
+      cache->head[size_class] = *(void **)spill;
+      *(void **)spill = pool_class->free_list;
+      pool_class->free_list = spill;
+    }
+    cache->count[size_class] -= JOLT_POOL_CACHE_MAX / 2;
+  }
+}
+
+inline void *jolt_pool_allocate(size_t size)
+{
+  return jolt_pool_aligned_allocate(size, 16);
+}
+
+inline void *jolt_pool_reallocate(void *ptr, size_t old_size, size_t new_size)
+{
+  if (!ptr)
+    return jolt_pool_allocate(new_size);
+
+  // Grow or shrink in place while the block still fits
+  JoltPoolHeader *header = (JoltPoolHeader *)ptr - 1;
+  if (header->size_class != JOLT_POOL_LARGE &&
+      header->offset + new_size <= jolt_pool_block_size(header->size_class))
+  {
+    header->size = new_size;
+    return ptr;
+  }
+
+  void *result = jolt_pool_allocate(new_size);
+  if (result)
+    memcpy(result, ptr, old_size < new_size ? old_size : new_size);
+  jolt_pool_free(ptr);
+  return result;
+}
+
+// Call instead of JPH::RegisterDefaultAllocator, before anything is allocated through Jolt
+inline void jolt_pool_register()
+{
+  if (!g_jolt_pool.arena)
+    g_jolt_pool.arena = arena_alloc(GB(64), JOLT_POOL_CHUNK, 0);
+
+  JPH::Allocate = jolt_pool_allocate;
+  JPH::Reallocate = jolt_pool_reallocate;
+  JPH::Free = jolt_pool_free;
+  JPH::AlignedAllocate = jolt_pool_aligned_allocate;
+  JPH::AlignedFree = jolt_pool_free;
+}
+
+inline void jolt_pool_read_stats(JoltPoolStats *out)
+{
+  *out = {};
+  for (u32 i = 0; i < JOLT_POOL_CLASSES; ++i)
+  {
+    JoltPoolClass *pool_class = &g_jolt_pool.classes[i];
+    out->classes[i].block_size = (u32)jolt_pool_block_size(i);
+    out->classes[i].reserved_bytes = pool_class->reserved_bytes.load(std::memory_order_relaxed);
+    out->reserved_bytes += out->classes[i].reserved_bytes;
+  }
+
+  // A block freed on another thread than it was allocated on is counted there, only the
+  // sums over all threads are meaningful
+  u32 thread_count = g_jolt_pool.thread_count.load(std::memory_order_acquire);
+  for (u32 t = 0; t < thread_count; ++t)
+  {
+    JoltPoolThreadCache *cache = g_jolt_pool.threads[t];
+    for (u32 i = 0; i < JOLT_POOL_CLASSES; ++i)
+    {
+      out->classes[i].allocs += cache->allocs[i].load(std::memory_order_relaxed);
+      out->classes[i].frees += cache->frees[i].load(std::memory_order_relaxed);
+    }
+  }
+  out->large_allocs = g_jolt_pool.large_allocs.load(std::memory_order_relaxed);
+  out->large_frees = g_jolt_pool.large_frees.load(std::memory_order_relaxed);
+  out->large_live_bytes = g_jolt_pool.large_live_bytes.load(std::memory_order_relaxed);
+}
+
+#endif // JOLT_POOL_ALLOCATOR_H
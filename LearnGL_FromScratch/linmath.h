@@ -3,12 +3,13 @@
 
 #include <string.h>
 #include <math.h>
-#include <string.h>
-#include "arena2.h"
 
 /* 2021-03-21 Camilla Löwy <elmindreda@elmindreda.org>
  * - Replaced double constants with float equivalents
- * Modified to use custom memory arena for temporary allocations
+ * Temporaries live on the stack / in registers, no allocations.
+ * SSE or NEON backend for the hot matrix/quat ops, define LINMATH_NO_SIMD for scalar.
+ * mul, mul_vec4, invert and look_at keep the scalar evaluation order (no FMA) so
+ * both backends agree exactly (invert up to the sign of zero); quat_mul within an ulp.
  */
 
 #define DEG2RAD 0.017453292519943295f
@@ -19,6 +20,45 @@
 #define LINMATH_H_FUNC static inline
 #endif
 
+#if !defined(LINMATH_NO_SIMD) && (defined(__SSE__) || defined(_M_X64))
+#include <xmmintrin.h>
+#define LINMATH_SIMD 1
+typedef __m128 lm_v4;
+#define lm_load(p) _mm_loadu_ps(p)
+#define lm_store(p, v) _mm_storeu_ps(p, v)
+#define lm_set(x, y, z, w) _mm_setr_ps(x, y, z, w)
+#define lm_splat(s) _mm_set1_ps(s)
+#define lm_add(a, b) _mm_add_ps(a, b)
+#define lm_sub(a, b) _mm_sub_ps(a, b)
+#define lm_mul(a, b) _mm_mul_ps(a, b)
+#define lm_shuffle(v, x, y, z, w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+#define lm_lane(v, i) _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i)))
+#define lm_transpose(r0, r1, r2, r3) _MM_TRANSPOSE4_PS(r0, r1, r2, r3)
+#elif !defined(LINMATH_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LINMATH_SIMD 1
+typedef float32x4_t lm_v4;
+#define lm_load(p) vld1q_f32(p)
+#define lm_store(p, v) vst1q_f32(p, v)
+#define lm_set(x, y, z, w) ((lm_v4){x, y, z, w})
+#define lm_splat(s) vdupq_n_f32(s)
+#define lm_add(a, b) vaddq_f32(a, b)
+#define lm_sub(a, b) vsubq_f32(a, b)
+#define lm_mul(a, b) vmulq_f32(a, b)
+#define lm_shuffle(v, x, y, z, w) __builtin_shufflevector(v, v, x, y, z, w)
+#define lm_lane(v, i) vgetq_lane_f32(v, i)
+#define lm_transpose(r0, r1, r2, r3) do { \
+	float32x4x2_t t01_ = vtrnq_f32(r0, r1); \
+	float32x4x2_t t23_ = vtrnq_f32(r2, r3); \
+	r0 = vcombine_f32(vget_low_f32(t01_.val[0]), vget_low_f32(t23_.val[0])); \
+	r1 = vcombine_f32(vget_low_f32(t01_.val[1]), vget_low_f32(t23_.val[1])); \
+	r2 = vcombine_f32(vget_high_f32(t01_.val[0]), vget_high_f32(t23_.val[0])); \
+	r3 = vcombine_f32(vget_high_f32(t01_.val[1]), vget_high_f32(t23_.val[1])); \
+} while(0)
+#else
+#define LINMATH_SIMD 0
+#endif
+
 #define LINMATH_H_DEFINE_VEC(n) \
 typedef float vec##n[n]; \
 LINMATH_H_FUNC void vec##n##_add(vec##n r, vec##n const a, vec##n const b) \
@@ -170,29 +210,48 @@ LINMATH_H_FUNC void mat4x4_scale_aniso(mat4x4 M, mat4x4 const a, float x, float
 	vec4_scale(M[2], a[2], z);
 	vec4_dup(M[3], a[3]);
 }
-LINMATH_H_FUNC void mat4x4_mul(Arena *arena, mat4x4 M, mat4x4 const a, mat4x4 const b)
-{
-	Temp temp = temp_begin(arena);
-	mat4x4 *temp_mat = push_struct(temp.arena, mat4x4);
-	
+LINMATH_H_FUNC void mat4x4_mul(mat4x4 M, mat4x4 const a, mat4x4 const b)
+{
+#if LINMATH_SIMD
+	/* M may alias a or b: everything is loaded before the first store */
+	lm_v4 a0 = lm_load(a[0]), a1 = lm_load(a[1]), a2 = lm_load(a[2]), a3 = lm_load(a[3]);
+	lm_v4 r[4];
+	int c;
+	for(c=0; c<4; ++c) {
+		lm_v4 acc = lm_mul(a0, lm_splat(b[c][0]));
+		acc = lm_add(acc, lm_mul(a1, lm_splat(b[c][1])));
+		acc = lm_add(acc, lm_mul(a2, lm_splat(b[c][2])));
+		r[c] = lm_add(acc, lm_mul(a3, lm_splat(b[c][3])));
+	}
+	for(c=0; c<4; ++c)
+		lm_store(M[c], r[c]);
+#else
+	mat4x4 temp_mat;
 	int k, r, c;
 	for(c=0; c<4; ++c) for(r=0; r<4; ++r) {
-		(*temp_mat)[c][r] = 0.f;
+		temp_mat[c][r] = 0.f;
 		for(k=0; k<4; ++k)
-			(*temp_mat)[c][r] += a[k][r] * b[c][k];
+			temp_mat[c][r] += a[k][r] * b[c][k];
 	}
-	mat4x4_dup(M, *temp_mat);
-	
-	temp_end(temp);
+	mat4x4_dup(M, temp_mat);
+#endif
 }
 LINMATH_H_FUNC void mat4x4_mul_vec4(vec4 r, mat4x4 const M, vec4 const v)
 {
+#if LINMATH_SIMD
+	lm_v4 acc = lm_mul(lm_load(M[0]), lm_splat(v[0]));
+	acc = lm_add(acc, lm_mul(lm_load(M[1]), lm_splat(v[1])));
+	acc = lm_add(acc, lm_mul(lm_load(M[2]), lm_splat(v[2])));
+	acc = lm_add(acc, lm_mul(lm_load(M[3]), lm_splat(v[3])));
+	lm_store(r, acc);
+#else
 	int i, j;
 	for(j=0; j<4; ++j) {
 		r[j] = 0.f;
 		for(i=0; i<4; ++i)
 			r[j] += M[i][j] * v[i];
 	}
+#endif
 }
 LINMATH_H_FUNC void mat4x4_translate(mat4x4 T, float x, float y, float z)
 {
@@ -217,7 +276,7 @@ LINMATH_H_FUNC void mat4x4_from_vec3_mul_outer(mat4x4 M, vec3 const a, vec3 cons
 	for(i=0; i<4; ++i) for(j=0; j<4; ++j)
 		M[i][j] = i<3 && j<3 ? a[i] * b[j] : 0.f;
 }
-LINMATH_H_FUNC void mat4x4_rotate(Arena *arena, mat4x4 R, mat4x4 const M, float x, float y, float z, float angle)
+LINMATH_H_FUNC void mat4x4_rotate(mat4x4 R, mat4x4 const M, float x, float y, float z, float angle)
 {
 	float s = sinf(angle);
 	float c = cosf(angle);
@@ -225,85 +284,68 @@ LINMATH_H_FUNC void mat4x4_rotate(Arena *arena, mat4x4 R, mat4x4 const M, float
 
 	if(vec3_len(u) > 1e-4) {
 		vec3_norm(u, u);
-		
-		Temp temp = temp_begin(arena);
-		mat4x4 *T = push_struct(temp.arena, mat4x4);
-		mat4x4 *S = push_struct(temp.arena, mat4x4);
-		mat4x4 *C = push_struct(temp.arena, mat4x4);
-		
-		mat4x4_from_vec3_mul_outer(*T, u, u);
-
-		(*S)[0][0] = 0;    (*S)[0][1] = u[2];  (*S)[0][2] = -u[1]; (*S)[0][3] = 0;
-		(*S)[1][0] = -u[2]; (*S)[1][1] = 0;    (*S)[1][2] = u[0];  (*S)[1][3] = 0;
-		(*S)[2][0] = u[1];  (*S)[2][1] = -u[0]; (*S)[2][2] = 0;    (*S)[2][3] = 0;
-		(*S)[3][0] = 0;    (*S)[3][1] = 0;    (*S)[3][2] = 0;    (*S)[3][3] = 0;
-		
-		mat4x4_scale(*S, *S, s);
-
-		mat4x4_identity(*C);
-		mat4x4_sub(*C, *C, *T);
-		mat4x4_scale(*C, *C, c);
-
-		mat4x4_add(*T, *T, *C);
-		mat4x4_add(*T, *T, *S);
-
-		(*T)[3][3] = 1.f;
-		mat4x4_mul(arena, R, M, *T);
-		
-		temp_end(temp);
+		mat4x4 T;
+		mat4x4_from_vec3_mul_outer(T, u, u);
+
+		mat4x4 S = {
+			{    0,  u[2], -u[1], 0},
+			{-u[2],     0,  u[0], 0},
+			{ u[1], -u[0],     0, 0},
+			{    0,     0,     0, 0}
+		};
+		mat4x4_scale(S, S, s);
+
+		mat4x4 C;
+		mat4x4_identity(C);
+		mat4x4_sub(C, C, T);
+		mat4x4_scale(C, C, c);
+
+		mat4x4_add(T, T, C);
+		mat4x4_add(T, T, S);
+
+		T[3][3] = 1.f;
+		mat4x4_mul(R, M, T);
 	} else {
 		mat4x4_dup(R, M);
 	}
 }
-LINMATH_H_FUNC void mat4x4_rotate_X(Arena *arena, mat4x4 Q, mat4x4 const M, float angle)
+LINMATH_H_FUNC void mat4x4_rotate_X(mat4x4 Q, mat4x4 const M, float angle)
 {
 	float s = sinf(angle);
 	float c = cosf(angle);
-	
-	Temp temp = temp_begin(arena);
-	mat4x4 *R = push_struct(temp.arena, mat4x4);
-	
-	(*R)[0][0] = 1.f; (*R)[0][1] = 0.f; (*R)[0][2] = 0.f; (*R)[0][3] = 0.f;
-	(*R)[1][0] = 0.f; (*R)[1][1] = c;   (*R)[1][2] = s;   (*R)[1][3] = 0.f;
-	(*R)[2][0] = 0.f; (*R)[2][1] = -s;  (*R)[2][2] = c;   (*R)[2][3] = 0.f;
-	(*R)[3][0] = 0.f; (*R)[3][1] = 0.f; (*R)[3][2] = 0.f; (*R)[3][3] = 1.f;
-	
-	mat4x4_mul(arena, Q, M, *R);
-	temp_end(temp);
+	mat4x4 R = {
+		{1.f, 0.f, 0.f, 0.f},
+		{0.f,   c,   s, 0.f},
+		{0.f,  -s,   c, 0.f},
+		{0.f, 0.f, 0.f, 1.f}
+	};
+	mat4x4_mul(Q, M, R);
 }
 
-LINMATH_H_FUNC void mat4x4_rotate_Y(Arena *arena, mat4x4 Q, mat4x4 const M, float angle)
+LINMATH_H_FUNC void mat4x4_rotate_Y(mat4x4 Q, mat4x4 const M, float angle)
 {
 	float s = sinf(angle);
 	float c = cosf(angle);
-	
-	Temp temp = temp_begin(arena);
-	mat4x4 *R = push_struct(temp.arena, mat4x4);
-	
-	(*R)[0][0] = c;   (*R)[0][1] = 0.f; (*R)[0][2] = -s;  (*R)[0][3] = 0.f;
-	(*R)[1][0] = 0.f; (*R)[1][1] = 1.f; (*R)[1][2] = 0.f; (*R)[1][3] = 0.f;
-	(*R)[2][0] = s;   (*R)[2][1] = 0.f; (*R)[2][2] = c;   (*R)[2][3] = 0.f;
-	(*R)[3][0] = 0.f; (*R)[3][1] = 0.f; (*R)[3][2] = 0.f; (*R)[3][3] = 1.f;
-	
-	mat4x4_mul(arena, Q, M, *R);
-	temp_end(temp);
+	mat4x4 R = {
+		{   c, 0.f,  -s, 0.f},
+		{ 0.f, 1.f, 0.f, 0.f},
+		{   s, 0.f,   c, 0.f},
+		{ 0.f, 0.f, 0.f, 1.f}
+	};
+	mat4x4_mul(Q, M, R);
 }
 
-LINMATH_H_FUNC void mat4x4_rotate_Z(Arena *arena, mat4x4 Q, mat4x4 const M, float angle)
+LINMATH_H_FUNC void mat4x4_rotate_Z(mat4x4 Q, mat4x4 const M, float angle)
 {
 	float s = sinf(angle);
 	float c = cosf(angle);
-	
-	Temp temp = temp_begin(arena);
-	mat4x4 *R = push_struct(temp.arena, mat4x4);
-	
-	(*R)[0][0] = c;   (*R)[0][1] = s;   (*R)[0][2] = 0.f; (*R)[0][3] = 0.f;
-	(*R)[1][0] = -s;  (*R)[1][1] = c;   (*R)[1][2] = 0.f; (*R)[1][3] = 0.f;
-	(*R)[2][0] = 0.f; (*R)[2][1] = 0.f; (*R)[2][2] = 1.f; (*R)[2][3] = 0.f;
-	(*R)[3][0] = 0.f; (*R)[3][1] = 0.f; (*R)[3][2] = 0.f; (*R)[3][3] = 1.f;
-	
-	mat4x4_mul(arena, Q, M, *R);
-	temp_end(temp);
+	mat4x4 R = {
+		{   c,   s, 0.f, 0.f},
+		{  -s,   c, 0.f, 0.f},
+		{ 0.f, 0.f, 1.f, 0.f},
+		{ 0.f, 0.f, 0.f, 1.f}
+	};
+	mat4x4_mul(Q, M, R);
 }
 
 LINMATH_H_FUNC void mat4x4_invert(mat4x4 T, mat4x4 const M)
@@ -326,7 +368,31 @@ LINMATH_H_FUNC void mat4x4_invert(mat4x4 T, mat4x4 const M)
 	
 	/* Assumes it is invertible */
 	float idet = 1.0f/( s[0]*c[5]-s[1]*c[4]+s[2]*c[3]+s[3]*c[2]-s[4]*c[1]+s[5]*c[0] );
-	
+
+#if LINMATH_SIMD
+	/* Rows of M with pairs swapped: A_k = (M[1][k], M[0][k], M[3][k], M[2][k]).
+	 * Column j of T is then +-(A_x*k0 - A_y*k1 + A_z*k2) with k = (c,c,s,s). */
+	lm_v4 A0 = lm_load(M[0]), A1 = lm_load(M[1]), A2 = lm_load(M[2]), A3 = lm_load(M[3]);
+	lm_transpose(A0, A1, A2, A3);
+	A0 = lm_shuffle(A0, 1, 0, 3, 2);
+	A1 = lm_shuffle(A1, 1, 0, 3, 2);
+	A2 = lm_shuffle(A2, 1, 0, 3, 2);
+	A3 = lm_shuffle(A3, 1, 0, 3, 2);
+
+	lm_v4 k0 = lm_set(c[0], c[0], s[0], s[0]);
+	lm_v4 k1 = lm_set(c[1], c[1], s[1], s[1]);
+	lm_v4 k2 = lm_set(c[2], c[2], s[2], s[2]);
+	lm_v4 k3 = lm_set(c[3], c[3], s[3], s[3]);
+	lm_v4 k4 = lm_set(c[4], c[4], s[4], s[4]);
+	lm_v4 k5 = lm_set(c[5], c[5], s[5], s[5]);
+	lm_v4 pos = lm_set(idet, -idet, idet, -idet);
+	lm_v4 neg = lm_set(-idet, idet, -idet, idet);
+
+	lm_store(T[0], lm_mul(lm_add(lm_sub(lm_mul(A1, k5), lm_mul(A2, k4)), lm_mul(A3, k3)), pos));
+	lm_store(T[1], lm_mul(lm_add(lm_sub(lm_mul(A0, k5), lm_mul(A2, k2)), lm_mul(A3, k1)), neg));
+	lm_store(T[2], lm_mul(lm_add(lm_sub(lm_mul(A0, k4), lm_mul(A1, k2)), lm_mul(A3, k0)), pos));
+	lm_store(T[3], lm_mul(lm_add(lm_sub(lm_mul(A0, k3), lm_mul(A1, k1)), lm_mul(A2, k0)), neg));
+#else
 	T[0][0] = ( M[1][1] * c[5] - M[1][2] * c[4] + M[1][3] * c[3]) * idet;
 	T[0][1] = (-M[0][1] * c[5] + M[0][2] * c[4] - M[0][3] * c[3]) * idet;
 	T[0][2] = ( M[3][1] * s[5] - M[3][2] * s[4] + M[3][3] * s[3]) * idet;
@@ -346,6 +412,7 @@ LINMATH_H_FUNC void mat4x4_invert(mat4x4 T, mat4x4 const M)
 	T[3][1] = ( M[0][0] * c[3] - M[0][1] * c[1] + M[0][2] * c[0]) * idet;
 	T[3][2] = (-M[3][0] * s[3] + M[3][1] * s[1] - M[3][2] * s[0]) * idet;
 	T[3][3] = ( M[2][0] * s[3] - M[2][1] * s[1] + M[2][2] * s[0]) * idet;
+#endif
 }
 LINMATH_H_FUNC void mat4x4_orthonormalize(mat4x4 R, mat4x4 const M)
 {
@@ -408,6 +475,12 @@ LINMATH_H_FUNC void mat4x4_perspective(mat4x4 m, float y_fov, float aspect, floa
 	 * linmath.h uses radians for everything! */
 	float const a = 1.f / tanf(y_fov / 2.f);
 
+#if LINMATH_SIMD
+	lm_store(m[0], lm_set(a / aspect, 0.f, 0.f, 0.f));
+	lm_store(m[1], lm_set(0.f, a, 0.f, 0.f));
+	lm_store(m[2], lm_set(0.f, 0.f, -((f + n) / (f - n)), -1.f));
+	lm_store(m[3], lm_set(0.f, 0.f, -((2.f * f * n) / (f - n)), 0.f));
+#else
 	m[0][0] = a / aspect;
 	m[0][1] = 0.f;
 	m[0][2] = 0.f;
@@ -427,6 +500,7 @@ LINMATH_H_FUNC void mat4x4_perspective(mat4x4 m, float y_fov, float aspect, floa
 	m[3][1] = 0.f;
 	m[3][2] = -((2.f * f * n) / (f - n));
 	m[3][3] = 0.f;
+#endif
 }
 LINMATH_H_FUNC void mat4x4_look_at(mat4x4 m, vec3 const eye, vec3 const center, vec3 const up)
 {
@@ -447,6 +521,24 @@ LINMATH_H_FUNC void mat4x4_look_at(mat4x4 m, vec3 const eye, vec3 const center,
 	vec3 t;
 	vec3_mul_cross(t, s, f);
 
+#if LINMATH_SIMD
+	/* Rows are s, t, -f; then the same translate_in_place sum, lane-wise */
+	lm_v4 c0 = lm_set(s[0], s[1], s[2], 0.f);
+	lm_v4 c1 = lm_set(t[0], t[1], t[2], 0.f);
+	lm_v4 c2 = lm_set(-f[0], -f[1], -f[2], 0.f);
+	lm_v4 c3 = lm_set(0.f, 0.f, 0.f, 1.f);
+	lm_transpose(c0, c1, c2, c3);
+
+	lm_v4 acc = lm_mul(c0, lm_splat(-eye[0]));
+	acc = lm_add(acc, lm_mul(c1, lm_splat(-eye[1])));
+	acc = lm_add(acc, lm_mul(c2, lm_splat(-eye[2])));
+	acc = lm_add(acc, lm_mul(c3, lm_splat(0.f)));
+
+	lm_store(m[0], c0);
+	lm_store(m[1], c1);
+	lm_store(m[2], c2);
+	lm_store(m[3], lm_add(c3, acc));
+#else
 	m[0][0] =  s[0];
 	m[0][1] =  t[0];
 	m[0][2] = -f[0];
@@ -468,6 +560,7 @@ LINMATH_H_FUNC void mat4x4_look_at(mat4x4 m, vec3 const eye, vec3 const center,
 	m[3][3] =  1.f;
 
 	mat4x4_translate_in_place(m, -eye[0], -eye[1], -eye[2]);
+#endif
 }
 
 typedef float quat[4];
@@ -484,6 +577,14 @@ LINMATH_H_FUNC void quat_identity(quat q)
 }
 LINMATH_H_FUNC void quat_mul(quat r, quat const p, quat const q)
 {
+#if LINMATH_SIMD
+	lm_v4 Q = lm_load(q);
+	lm_v4 acc = lm_mul(lm_splat(p[3]), Q);
+	acc = lm_add(acc, lm_mul(lm_mul(lm_splat(p[0]), lm_shuffle(Q, 3, 2, 1, 0)), lm_set(1.f, -1.f, 1.f, -1.f)));
+	acc = lm_add(acc, lm_mul(lm_mul(lm_splat(p[1]), lm_shuffle(Q, 2, 3, 0, 1)), lm_set(1.f, 1.f, -1.f, -1.f)));
+	acc = lm_add(acc, lm_mul(lm_mul(lm_splat(p[2]), lm_shuffle(Q, 1, 0, 3, 2)), lm_set(-1.f, 1.f, 1.f, -1.f)));
+	lm_store(r, acc);
+#else
 	vec3 w;
 	vec3_mul_cross(r, p, q);
 	vec3_scale(w, p, q[3]);
@@ -491,6 +592,7 @@ LINMATH_H_FUNC void quat_mul(quat r, quat const p, quat const q)
 	vec3_scale(w, q, p[3]);
 	vec3_add(r, r, w);
 	r[3] = p[3]*q[3] - vec3_mul_inner(p, q);
+#endif
 }
 LINMATH_H_FUNC void quat_conj(quat r, quat const q)
 {
@@ -601,42 +703,34 @@ LINMATH_H_FUNC void quat_from_mat4x4(quat q, mat4x4 const M)
 	q[3] = (M[p[2]][p[1]] - M[p[1]][p[2]])/(2.f*r);
 }
 
-LINMATH_H_FUNC void mat4x4_arcball(Arena *arena, mat4x4 R, mat4x4 const M, vec2 const _a, vec2 const _b, float s)
+LINMATH_H_FUNC void mat4x4_arcball(mat4x4 R, mat4x4 const M, vec2 const _a, vec2 const _b, float s)
 {
-	Temp temp = temp_begin(arena);
-	
-	vec2 *a = push_struct(temp.arena, vec2);
-	vec2 *b = push_struct(temp.arena, vec2);
-	memcpy(*a, _a, sizeof(vec2));
-	memcpy(*b, _b, sizeof(vec2));
+	vec2 a, b;
+	memcpy(a, _a, sizeof(vec2));
+	memcpy(b, _b, sizeof(vec2));
 	
 	float z_a = 0.f;
 	float z_b = 0.f;
 
-	if(vec2_len(*a) < 1.f) {
-		z_a = sqrtf(1.f - vec2_mul_inner(*a, *a));
+	if(vec2_len(a) < 1.f) {
+		z_a = sqrtf(1.f - vec2_mul_inner(a, a));
 	} else {
-		vec2_norm(*a, *a);
+		vec2_norm(a, a);
 	}
 
-	if(vec2_len(*b) < 1.f) {
-		z_b = sqrtf(1.f - vec2_mul_inner(*b, *b));
+	if(vec2_len(b) < 1.f) {
+		z_b = sqrtf(1.f - vec2_mul_inner(b, b));
 	} else {
-		vec2_norm(*b, *b);
+		vec2_norm(b, b);
 	}
 	
-	vec3 *a_ = push_struct(temp.arena, vec3);
-	vec3 *b_ = push_struct(temp.arena, vec3);
-	vec3 *c_ = push_struct(temp.arena, vec3);
-	
-	(*a_)[0] = (*a)[0]; (*a_)[1] = (*a)[1]; (*a_)[2] = z_a;
-	(*b_)[0] = (*b)[0]; (*b_)[1] = (*b)[1]; (*b_)[2] = z_b;
+	vec3 a_ = {a[0], a[1], z_a};
+	vec3 b_ = {b[0], b[1], z_b};
+	vec3 c_;
 
-	vec3_mul_cross(*c_, *a_, *b_);
+	vec3_mul_cross(c_, a_, b_);
 
-	float const angle = acos(vec3_mul_inner(*a_, *b_)) * s;
-	mat4x4_rotate(arena, R, M, (*c_)[0], (*c_)[1], (*c_)[2], angle);
-	
-	temp_end(temp);
+	float const angle = acos(vec3_mul_inner(a_, b_)) * s;
+	mat4x4_rotate(R, M, c_[0], c_[1], c_[2], angle);
 }
 #endif
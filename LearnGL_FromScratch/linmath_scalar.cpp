@@ -0,0 +1,7 @@
+// Scalar linmath backend for bench_linmath, the reference the SIMD paths are checked against
+#define LINMATH_NO_SIMD
+#include "defines.h"
+#include "linmath.h"
+
+#define LINMATH_OPS(name) scalar_##name
+#include "bench_linmath_ops.inl"
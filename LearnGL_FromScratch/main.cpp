@@ -68,6 +68,7 @@ GameAPI load_game_api(const char *dll_path)
   api.init = (void (*)(GameMemory *))dlsym(api.dll_handle, "game_init");
   api.update = (void (*)(GameMemory *, GameInput*))dlsym(api.dll_handle, "game_update");
   api.render = (void (*)(GameMemory *))dlsym(api.dll_handle, "game_render");
+  api.before_reload = (void (*)(GameMemory *))dlsym(api.dll_handle, "game_before_reload");
   api.hot_reloaded = (void (*)(GameMemory *))dlsym(api.dll_handle, "game_hot_reloaded");
   api.shutdown = (void (*)(GameMemory *))dlsym(api.dll_handle, "game_shutdown");
 
@@ -153,6 +154,10 @@ int main()
       {
         printf("\n>>> Detected game.dylib change, reloading...\n");
 
+        if (game_api.before_reload)
+        {
+          game_api.before_reload(game_memory);
+        }
         unload_game_api(&game_api);
         usleep(100000); // 100ms delay
 
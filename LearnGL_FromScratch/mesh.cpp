@@ -1,42 +1,209 @@
 #include "mesh.h"
+#include <Jolt/Core/StreamIn.h>
+#include <Jolt/Core/StreamOut.h>
 #include <cmath>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <sys/stat.h>
 
-JPH::ConvexHullShapeSettings Mesh::create_convex_hull()
+// Flat-shaded meshes repeat each corner once per face, the hull only needs it once
+JPH::Array<JPH::Vec3> Mesh::convex_hull_points() const
 {
-  JPH::Array<JPH::Vec3> verts;
-  verts.reserve(vertex_count);
-  JPH::Float3 *vertices_ptr = reinterpret_cast<JPH::Float3 *>(vertices->positions);
-  verts.assign(vertices_ptr, vertices_ptr + vertex_count);
-
-  JPH::IndexedTriangleList triangles;
-  triangles.reserve(index_count / 3);
-  for (s32 i = 0; i < index_count; i += 3)
+  JPH::Array<JPH::Float3> unique(reinterpret_cast<const JPH::Float3 *>(vertices->positions),
+                                 reinterpret_cast<const JPH::Float3 *>(vertices->positions) + vertex_count);
+  std::sort(unique.begin(), unique.end(), [](const JPH::Float3 &a, const JPH::Float3 &b)
+            { return a.x < b.x || (a.x == b.x && (a.y < b.y || (a.y == b.y && a.z < b.z))); });
+  unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+  JPH::Array<JPH::Vec3> points;
+  points.reserve(unique.size());
+  for (const JPH::Float3 &p : unique)
+    points.push_back(JPH::Vec3(p));
+  return points;
+}
+
+JPH::ConvexHullShapeSettings Mesh::create_convex_hull() const
+{
+  return JPH::ConvexHullShapeSettings(convex_hull_points(), JPH::cDefaultConvexRadius);
+}
+
+class HullFileOut final : public JPH::StreamOut
+{
+public:
+  explicit HullFileOut(FILE *file) : file(file) {}
+  virtual void WriteBytes(const void *data, size_t size) override { failed |= fwrite(data, 1, size, file) != size; }
+  virtual bool IsFailed() const override { return failed; }
+
+private:
+  FILE *file;
+  bool failed = false;
+};
+
+class HullFileIn final : public JPH::StreamIn
+{
+public:
+  explicit HullFileIn(FILE *file) : file(file) {}
+  virtual void ReadBytes(void *data, size_t size) override { failed |= fread(data, 1, size, file) != size; }
+  virtual bool IsEOF() const override { return feof(file) != 0; }
+  virtual bool IsFailed() const override { return failed; }
+
+private:
+  FILE *file;
+  bool failed = false;
+};
+
+#define HULL_FILE_MAGIC 0x4c4c5548u // "HULL"
+#define HULL_FILE_VERSION 2u
+
+struct HullFileHeader
+{
+  u32 magic;
+  u32 version;
+  u32 hash_high; // upper half of the 64-bit hash, the file name only holds the lower half
+  u32 point_count;
+};
+
+// Hull file name is the low 32 bits of the 64-bit FNV-1a hash of the deduplicated points and
+// convex radius. The header stores the high 32 bits and the point count, so a file whose name
+// collides with another point set is rebuilt.
+JPH::RefConst<JPH::Shape> Mesh::load_convex_hull(const char *cache_dir) const
+{
+  JPH::Array<JPH::Vec3> points = convex_hull_points();
+  const r32 convex_radius = JPH::cDefaultConvexRadius;
+
+  u64 hash = 14695981039346656037ull;
+  auto hash_bytes = [&hash](const void *data, size_t size)
+  {
+    for (size_t i = 0; i < size; ++i)
+      hash = (hash ^ ((const u8 *)data)[i]) * 1099511628211ull;
+  };
+  for (const JPH::Vec3 &p : points)
   {
-    triangles.emplace_back(
-        indices[i + 0],
-        indices[i + 1],
-        indices[i + 2]);
+    r32 xyz[3] = {p.GetX(), p.GetY(), p.GetZ()};
+    hash_bytes(xyz, sizeof(xyz));
   }
-  return JPH::ConvexHullShapeSettings(verts, JPH::cDefaultConvexRadius);
+  hash_bytes(&convex_radius, sizeof(convex_radius));
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/hull_%08x.bin", cache_dir, (u32)hash);
+  HullFileHeader expected = {HULL_FILE_MAGIC, HULL_FILE_VERSION, (u32)(hash >> 32), (u32)points.size()};
+
+  if (FILE *file = fopen(path, "rb"))
+  {
+    HullFileHeader header = {};
+    HullFileIn in(file);
+    in.ReadBytes(&header, sizeof(header));
+    if (!in.IsFailed() && memcmp(&header, &expected, sizeof(header)) == 0)
+    {
+      JPH::Shape::ShapeResult restored = JPH::Shape::sRestoreFromBinaryState(in);
+      if (restored.IsValid() && !in.IsFailed())
+      {
+        fclose(file);
+        return restored.Get();
+      }
+    }
+    fclose(file);
+    fprintf(stderr, "Hull cache: rebuilding stale %s\n", path);
+  }
+
+  JPH::ShapeSettings::ShapeResult result = JPH::ConvexHullShapeSettings(points, convex_radius).Create();
+  if (result.HasError())
+  {
+    fprintf(stderr, "Convex hull failed: %s\n", result.GetError().c_str());
+    return nullptr;
+  }
+
+#ifdef _WIN32
+  _mkdir(cache_dir);
+#else
+  mkdir(cache_dir, 0755);
+#endif
+  if (FILE *file = fopen(path, "wb"))
+  {
+    HullFileOut out(file);
+    out.WriteBytes(&expected, sizeof(expected));
+    result.Get()->SaveBinaryState(out);
+    fclose(file);
+    if (out.IsFailed())
+      remove(path);
+  }
+  return result.Get();
+}
+
+u32 pack_snorm_10_10_10_2(r32 x, r32 y, r32 z, r32 w)
+{
+  auto snorm = [](r32 v, r32 scale, u32 mask) -> u32
+  {
+    v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    return (u32)(s32)lroundf(v * scale) & mask;
+  };
+  return snorm(x, 511.0f, 0x3FF) | (snorm(y, 511.0f, 0x3FF) << 10) | (snorm(z, 511.0f, 0x3FF) << 20) | (snorm(w, 1.0f, 0x3) << 30);
+}
+
+u32 pack_unorm8x4(r32 r, r32 g, r32 b, r32 a)
+{
+  auto unorm = [](r32 v) -> u32
+  {
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (u32)lroundf(v * 255.0f);
+  };
+  return unorm(r) | (unorm(g) << 8) | (unorm(b) << 16) | (unorm(a) << 24);
 }
 
-void Mesh::create(Arena *arena, Vertex *verts, s32 vert_count, u32 *inds, s32 ind_count, GraphicsAPI *gfx)
+void Mesh::create(Arena *arena, Vertex *verts, s32 vert_count, u32 *inds, s32 ind_count, GraphicsAPI *gfx,
+                  VertexLayout vertex_layout)
 {
   vertices = verts;
   vertex_count = vert_count;
   indices = inds;
   index_count = ind_count;
+  layout = vertex_layout;
   model = push_struct_no_zero(arena, mat4x4);
   mat4x4_identity(*model);
 
+  // Headless: keep CPU-side data only (convex hulls still need it)
+  if (!gfx)
+    return;
+
+  ebo = gfx->create_index_buffer(arena, indices, index_count * sizeof(u32));
+
+  if (layout == VertexLayout::PACKED)
+  {
+    // The float streams stay on the CPU side for convex hulls, only the packed copy is uploaded
+    PackedVertex *packed = push_array_no_zero(arena, PackedVertex, vertex_count);
+    for (s32 i = 0; i < vertex_count; ++i)
+    {
+      const r32 *p = verts->positions + 3 * i;
+      const r32 *n = verts->normals + 3 * i;
+      const r32 *c = verts->colors + 3 * i;
+      packed[i].position[0] = p[0];
+      packed[i].position[1] = p[1];
+      packed[i].position[2] = p[2];
+      packed[i].normal = pack_snorm_10_10_10_2(n[0], n[1], n[2]);
+      packed[i].color = pack_unorm8x4(c[0], c[1], c[2]);
+    }
+    vertex_vbo = gfx->create_buffer(arena, packed, vertex_count * sizeof(PackedVertex));
+
+    vao = gfx->create_vertex_array(arena);
+    gfx->bind_vertex_array(vao);
+    gfx->bind_buffer(vertex_vbo);
+    gfx->enable_vertex_attrib(0);
+    gfx->vertex_attrib_format_pointer(0, 3, VERTEX_ATTRIB_FLOAT, sizeof(PackedVertex), offsetof(PackedVertex, position));
+    gfx->enable_vertex_attrib(1);
+    gfx->vertex_attrib_format_pointer(1, 4, VERTEX_ATTRIB_SNORM_10_10_10_2, sizeof(PackedVertex), offsetof(PackedVertex, normal));
+    gfx->enable_vertex_attrib(2);
+    gfx->vertex_attrib_format_pointer(2, 4, VERTEX_ATTRIB_UNORM8, sizeof(PackedVertex), offsetof(PackedVertex, color));
+    gfx->bind_index_buffer(ebo);
+    gfx->bind_vertex_array(nullptr);
+    return;
+  }
+
   // Create vertex buffer
   position_vbo = gfx->create_buffer(arena, verts->positions, vertex_count * 3 * sizeof(r32));
   normal_vbo = gfx->create_buffer(arena, verts->normals, vertex_count * 3 * sizeof(r32));
   color_vbo = gfx->create_buffer(arena, verts->colors, vertex_count * 3 * sizeof(r32));
 
-  // Create index buffer
-  ebo = gfx->create_index_buffer(arena, indices, index_count * sizeof(u32));
-
   // Create and setup VAO
   vao = gfx->create_vertex_array(arena);
   gfx->bind_vertex_array(vao);
@@ -65,6 +232,14 @@ void Mesh::draw(GraphicsAPI *gfx) const
   gfx->bind_vertex_array(nullptr);
 }
 
+// Instance attributes (locations 3-7) must already be bound to the VAO
+void Mesh::draw_instanced(GraphicsAPI *gfx, s32 instance_count) const
+{
+  gfx->bind_vertex_array(vao);
+  gfx->draw_elements_instanced(index_count, instance_count);
+  gfx->bind_vertex_array(nullptr);
+}
+
 void Mesh::destroy(GraphicsAPI *gfx)
 {
   if (vao)
@@ -75,6 +250,8 @@ void Mesh::destroy(GraphicsAPI *gfx)
     gfx->destroy_buffer(normal_vbo);
   if (color_vbo)
     gfx->destroy_buffer(color_vbo);    
+  if (vertex_vbo)
+    gfx->destroy_buffer(vertex_vbo);
   if (ebo)
     gfx->destroy_buffer(ebo);
 
@@ -82,6 +259,7 @@ void Mesh::destroy(GraphicsAPI *gfx)
   position_vbo = nullptr;
   normal_vbo = nullptr;
   color_vbo = nullptr;
+  vertex_vbo = nullptr;
   ebo = nullptr;
 
   vertices = nullptr;
@@ -98,7 +276,7 @@ void Mesh::translate(r32 x, r32 y, r32 z)
   normals[(idx)*3+0] = nx; normals[(idx)*3+1] = ny; normals[(idx)*3+2] = nz; \
   colors[(idx)*3+0] = cr; colors[(idx)*3+1] = cg; colors[(idx)*3+2] = cb;
 
-Mesh *Mesh::create_ground(Arena *arena, GraphicsAPI *gfx, r32 size, r32 r, r32 g, r32 b)
+Mesh *Mesh::create_ground(Arena *arena, GraphicsAPI *gfx, r32 size, r32 r, r32 g, r32 b, VertexLayout layout)
 {
   r32 *positions = push_array(arena, r32, 4 * 3);
   r32 *normals = push_array(arena, r32, 4 * 3);
@@ -118,12 +296,12 @@ Mesh *Mesh::create_ground(Arena *arena, GraphicsAPI *gfx, r32 size, r32 r, r32 g
   *vertices = {positions, normals, colors};
 
   Mesh *mesh = push_struct(arena, Mesh);
-  mesh->create(arena, vertices, 4, indices, 6, gfx);
+  mesh->create(arena, vertices, 4, indices, 6, gfx, layout);
   return mesh;
 }
 
 // ========== Box ==========
-Mesh *Mesh::create_box(Arena *arena, GraphicsAPI *gfx, r32 w, r32 h, r32 d, r32 r, r32 g, r32 b)
+Mesh *Mesh::create_box(Arena *arena, GraphicsAPI *gfx, r32 w, r32 h, r32 d, r32 r, r32 g, r32 b, VertexLayout layout)
 {
   r32 *positions = push_array(arena, r32, 24 * 3);
   r32 *normals = push_array(arena, r32, 24 * 3);
@@ -183,14 +361,14 @@ Mesh *Mesh::create_box(Arena *arena, GraphicsAPI *gfx, r32 w, r32 h, r32 d, r32
   *vertex_data = {positions, normals, colors};
 
   Mesh *mesh = push_struct(arena, Mesh);
-  mesh->create(arena, vertex_data, 24, indices, 36, gfx);
+  mesh->create(arena, vertex_data, 24, indices, 36, gfx, layout);
   return mesh;
 }
 
 
 // ========== Sphere ==========
 Mesh *Mesh::create_sphere(Arena *arena, GraphicsAPI *gfx, r32 radius, s32 sectors, s32 stacks,
-                          r32 r, r32 g, r32 b)
+                          r32 r, r32 g, r32 b, VertexLayout layout)
 {
   s32 vert_count = (stacks + 1) * (sectors + 1);
   s32 ind_count = stacks * sectors * 6;
@@ -255,13 +433,13 @@ Mesh *Mesh::create_sphere(Arena *arena, GraphicsAPI *gfx, r32 radius, s32 sector
   *vertex_data = {positions, normals, colors};
 
   Mesh *mesh = push_struct(arena, Mesh);
-  mesh->create(arena, vertex_data, vert_count,  indices, ind_count, gfx);
+  mesh->create(arena, vertex_data, vert_count, indices, ind_count, gfx, layout);
   return mesh;
 }
 
 // ========== Cylinder ==========
 Mesh *Mesh::create_cylinder(Arena *arena, GraphicsAPI *gfx, r32 radius, r32 height, s32 sectors,
-                           r32 r, r32 g, r32 b)
+                           r32 r, r32 g, r32 b, VertexLayout layout)
 {
   // Calculate sizes: side (2*(sectors+1)) + top cap (1 + sectors+1) + bottom cap (1 + sectors+1)
   s32 vert_count = 2 * (sectors + 1) + 2 * (sectors + 2);
@@ -366,13 +544,13 @@ Mesh *Mesh::create_cylinder(Arena *arena, GraphicsAPI *gfx, r32 radius, r32 heig
   *vertex_data = {positions, normals, colors};
 
   Mesh *mesh = push_struct(arena, Mesh);
-  mesh->create(arena, vertex_data, v, indices, idx, gfx);
+  mesh->create(arena, vertex_data, v, indices, idx, gfx, layout);
   return mesh;
 }
 
 // ========== Cone ==========
 Mesh *Mesh::create_cone(Arena *arena, GraphicsAPI *gfx, r32 radius, r32 height, s32 sectors,
-                       r32 r, r32 g, r32 b)
+                       r32 r, r32 g, r32 b, VertexLayout layout)
 {
   // Apex (1) + base circle (sectors+1) + bottom cap center (1) + bottom circle (sectors+1)
   s32 vert_count = 1 + (sectors + 1) + 1 + (sectors + 1);
@@ -450,6 +628,105 @@ Mesh *Mesh::create_cone(Arena *arena, GraphicsAPI *gfx, r32 radius, r32 height,
   *vertex_data = {positions, normals, colors};
 
   Mesh *mesh = push_struct(arena, Mesh);
-  mesh->create(arena, vertex_data, v, indices, idx, gfx);
+  mesh->create(arena, vertex_data, v, indices, idx, gfx, layout);
+  return mesh;
+}
+
+// ========== Geometry cache ==========
+GeometryCache *geometry_cache_create(Arena *arena, u32 capacity, VertexLayout layout)
+{
+  u32 pow2 = 16;
+  while (pow2 < capacity * 2) // keep load <= 1/2
+    pow2 <<= 1;
+
+  GeometryCache *cache = push_struct(arena, GeometryCache);
+  cache->capacity = pow2;
+  cache->layout = layout;
+  cache->keys = push_array(arena, GeometryKey, pow2);
+  cache->meshes = push_array(arena, Mesh *, pow2);
+  return cache;
+}
+
+static u32 geometry_key_hash(const GeometryKey &key)
+{
+  const u8 *bytes = (const u8 *)&key;
+  u32 hash = 2166136261u;
+  for (size_t i = 0; i < sizeof(GeometryKey); ++i)
+    hash = (hash ^ bytes[i]) * 16777619u;
+  return hash;
+}
+
+static Mesh *geometry_build(Arena *arena, GraphicsAPI *gfx, const GeometryKey &key, VertexLayout layout)
+{
+  switch (key.primitive)
+  {
+  case MeshPrimitive::GROUND:
+    return Mesh::create_ground(arena, gfx, key.dims[0], 1.0f, 1.0f, 1.0f, layout);
+  case MeshPrimitive::BOX:
+    return Mesh::create_box(arena, gfx, key.dims[0], key.dims[1], key.dims[2], 1.0f, 1.0f, 1.0f, layout);
+  case MeshPrimitive::SPHERE:
+    return Mesh::create_sphere(arena, gfx, key.dims[0], key.sectors, key.stacks, 1.0f, 1.0f, 1.0f, layout);
+  case MeshPrimitive::CYLINDER:
+    return Mesh::create_cylinder(arena, gfx, key.dims[0], key.dims[1], key.sectors, 1.0f, 1.0f, 1.0f, layout);
+  case MeshPrimitive::CONE:
+    return Mesh::create_cone(arena, gfx, key.dims[0], key.dims[1], key.sectors, 1.0f, 1.0f, 1.0f, layout);
+  }
+  return nullptr;
+}
+
+static void geometry_cache_grow(GeometryCache *cache, Arena *arena)
+{
+  GeometryKey *old_keys = cache->keys;
+  Mesh **old_meshes = cache->meshes;
+  u32 old_capacity = cache->capacity;
+
+  // Old slots stay in the arena, the cache only ever grows a few times
+  cache->capacity = old_capacity * 2;
+  cache->keys = push_array(arena, GeometryKey, cache->capacity);
+  cache->meshes = push_array(arena, Mesh *, cache->capacity);
+
+  u32 mask = cache->capacity - 1;
+  for (u32 i = 0; i < old_capacity; ++i)
+  {
+    if (!old_meshes[i])
+      continue;
+    u32 slot = geometry_key_hash(old_keys[i]) & mask;
+    while (cache->meshes[slot])
+      slot = (slot + 1) & mask;
+    cache->keys[slot] = old_keys[i];
+    cache->meshes[slot] = old_meshes[i];
+  }
+}
+
+Mesh *geometry_cache_get(GeometryCache *cache, Arena *arena, GraphicsAPI *gfx, GeometryKey key)
+{
+  u32 mask = cache->capacity - 1;
+  u32 slot = geometry_key_hash(key) & mask;
+  for (; cache->meshes[slot]; slot = (slot + 1) & mask)
+  {
+    if (memcmp(&cache->keys[slot], &key, sizeof(GeometryKey)) == 0)
+    {
+      cache->hits++;
+      return cache->meshes[slot];
+    }
+  }
+
+  Mesh *mesh = geometry_build(arena, gfx, key, cache->layout);
+  cache->misses++;
+  if (!mesh)
+    return nullptr;
+
+  if ((cache->count + 1) * 2 > cache->capacity)
+  {
+    geometry_cache_grow(cache, arena);
+    mask = cache->capacity - 1;
+    slot = geometry_key_hash(key) & mask;
+    while (cache->meshes[slot])
+      slot = (slot + 1) & mask;
+  }
+
+  cache->keys[slot] = key;
+  cache->meshes[slot] = mesh;
+  cache->count++;
   return mesh;
 }
@@ -6,6 +6,8 @@
 #include "linmath.h"
 #include "physics.h"
 
+#define HULL_CACHE_DIR "hull_cache"
+
 struct Vertex
 {
   r32 *positions;
@@ -13,6 +15,24 @@ struct Vertex
   r32 *colors;
 };
 
+// GPU vertex layout. SEPARATE: three float3 streams (36 bytes/vertex).
+// PACKED: one interleaved PackedVertex stream (20 bytes/vertex)
+enum class VertexLayout : u32
+{
+  SEPARATE = 0,
+  PACKED,
+};
+
+struct PackedVertex
+{
+  r32 position[3];
+  u32 normal; // snorm 10:10:10:2
+  u32 color;  // RGBA8
+};
+
+u32 pack_snorm_10_10_10_2(r32 x, r32 y, r32 z, r32 w = 0.0f);
+u32 pack_unorm8x4(r32 r, r32 g, r32 b, r32 a = 1.0f);
+
 struct Mesh
 {
   // Opaque GPU handles (backend-agnostic)
@@ -20,8 +40,10 @@ struct Mesh
   GraphicsBuffer position_vbo;
   GraphicsBuffer normal_vbo;
   GraphicsBuffer color_vbo;
+  GraphicsBuffer vertex_vbo; // PACKED layout only
   GraphicsBuffer ebo;
   s32 index_count;
+  VertexLayout layout;
 
   // CPU-side data (optional - can free after upload)
   Vertex *vertices;
@@ -29,20 +51,74 @@ struct Mesh
   s32 vertex_count;
   mat4x4 *model;
 
-  Mesh() : vao(nullptr), position_vbo(nullptr), normal_vbo(nullptr), color_vbo(nullptr), ebo(nullptr),
-           index_count(0), vertices(nullptr), indices(nullptr), vertex_count(0) {}
+  Mesh() : vao(nullptr), position_vbo(nullptr), normal_vbo(nullptr), color_vbo(nullptr), vertex_vbo(nullptr), ebo(nullptr),
+           index_count(0), layout(VertexLayout::SEPARATE), vertices(nullptr), indices(nullptr), vertex_count(0) {}
 
-  void create(Arena *arena, Vertex *verts, s32 vert_count, u32 *inds, s32 ind_count, GraphicsAPI *gfx);
+  void create(Arena *arena, Vertex *verts, s32 vert_count, u32 *inds, s32 ind_count, GraphicsAPI *gfx,
+              VertexLayout vertex_layout = VertexLayout::PACKED);
   void draw(GraphicsAPI *gfx) const;
+  void draw_instanced(GraphicsAPI *gfx, s32 instance_count) const;
   void destroy(GraphicsAPI *gfx);
   void translate(r32 x, r32 y, r32 z);
-  JPH::ConvexHullShapeSettings create_convex_hull();
+  JPH::Array<JPH::Vec3> convex_hull_points() const;
+  JPH::ConvexHullShapeSettings create_convex_hull() const;
+  // Loads the hull from cache_dir if a matching binary exists, otherwise builds and stores it
+  JPH::RefConst<JPH::Shape> load_convex_hull(const char *cache_dir) const;
+
+  static Mesh *create_ground(Arena *arena, GraphicsAPI *gfx, r32 size, r32 r = 0.2f, r32 g = 0.3f, r32 b = 0.2f,
+                             VertexLayout layout = VertexLayout::PACKED);
+  static Mesh *create_box(Arena *arena, GraphicsAPI *gfx, r32 w, r32 h, r32 d, r32 r = 0.8f, r32 g = 0.2f, r32 b = 0.2f,
+                          VertexLayout layout = VertexLayout::PACKED);
+  static Mesh *create_sphere(Arena *arena, GraphicsAPI *gfx, r32 radius, s32 sectors = 36, s32 stacks = 18, r32 r = 0.2f, r32 g = 0.2f, r32 b = 0.8f,
+                             VertexLayout layout = VertexLayout::PACKED);
+  static Mesh *create_cylinder(Arena *arena, GraphicsAPI *gfx, r32 radius, r32 height, s32 sectors = 36, r32 r = 0.8f, r32 g = 0.8f, r32 b = 0.2f,
+                               VertexLayout layout = VertexLayout::PACKED);
+  static Mesh *create_cone(Arena *arena, GraphicsAPI *gfx, r32 radius, r32 height, s32 sectors = 36, r32 r = 0.8f, r32 g = 0.4f, r32 b = 0.2f,
+                           VertexLayout layout = VertexLayout::PACKED);
+};
 
-  static Mesh *create_ground(Arena *arena, GraphicsAPI *gfx, r32 size, r32 r = 0.2f, r32 g = 0.3f, r32 b = 0.2f);
-  static Mesh *create_box(Arena *arena, GraphicsAPI *gfx, r32 w, r32 h, r32 d, r32 r = 0.8f, r32 g = 0.2f, r32 b = 0.2f);
-  static Mesh *create_sphere(Arena *arena, GraphicsAPI *gfx, r32 radius, s32 sectors = 36, s32 stacks = 18, r32 r = 0.2f, r32 g = 0.2f, r32 b = 0.8f);
-  static Mesh *create_cylinder(Arena *arena, GraphicsAPI *gfx, r32 radius, r32 height, s32 sectors = 36, r32 r = 0.8f, r32 g = 0.8f, r32 b = 0.2f);
-  static Mesh *create_cone(Arena *arena, GraphicsAPI *gfx, r32 radius, r32 height, s32 sectors = 36, r32 r = 0.8f, r32 g = 0.4f, r32 b = 0.2f);
+enum class MeshPrimitive : u32
+{
+  GROUND = 0,
+  BOX,
+  SPHERE,
+  CYLINDER,
+  CONE,
+};
+
+// dims: ground (size), box (half extents), sphere (radius), cylinder/cone (radius, height)
+struct GeometryKey
+{
+  MeshPrimitive primitive;
+  r32 dims[3];
+  s32 sectors, stacks;
+};
+
+inline GeometryKey geometry_key(MeshPrimitive primitive, r32 a, r32 b = 0.0f, r32 c = 0.0f, s32 sectors = 0, s32 stacks = 0)
+{
+  GeometryKey key = {};
+  key.primitive = primitive;
+  key.dims[0] = a;
+  key.dims[1] = b;
+  key.dims[2] = c;
+  key.sectors = sectors;
+  key.stacks = stacks;
+  return key;
+}
+
+// One shared Mesh per key, open addressing. Meshes are built with white vertex colors,
+// per-object color and transform live on the Object / pose side.
+struct GeometryCache
+{
+  GeometryKey *keys;
+  Mesh **meshes;
+  u32 capacity; // power of two
+  u32 count;
+  VertexLayout layout;
+  u32 hits, misses;
 };
 
+GeometryCache *geometry_cache_create(Arena *arena, u32 capacity, VertexLayout layout = VertexLayout::PACKED);
+Mesh *geometry_cache_get(GeometryCache *cache, Arena *arena, GraphicsAPI *gfx, GeometryKey key);
+
 #endif // MESH_H
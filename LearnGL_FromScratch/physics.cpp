@@ -1,31 +1,921 @@
 #include "physics.h"
 #include "game_api.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
 
-void draw_physics(GameMemory *memory, mat4x4 view, mat4x4 projection)
+#ifdef JPH_EXTERNAL_PROFILE
+// Jolt's own JPH_PROFILE zones (step phases, per-job work) go to the same per-thread rings.
+// libJolt has to be built with JPH_EXTERNAL_PROFILE too, the class layout must match.
+static_assert(sizeof(ProfileScope) <= 64, "ProfileScope must fit ExternalProfileMeasurement::mUserData");
+
+JPH::ExternalProfileMeasurement::ExternalProfileMeasurement(const char *inName, JPH::uint32 inColor)
+{
+  new (mUserData) ProfileScope(inName);
+}
+
+JPH::ExternalProfileMeasurement::~ExternalProfileMeasurement()
+{
+  ((ProfileScope *)mUserData)->~ProfileScope();
+}
+#endif
+
+// Uploads batches Jolt created since last frame, then streams this frame's instances sorted
+// by (batch, draw mode) and draws each group with one instanced call
+static void draw_debug_geometry(GameMemory *memory, mat4x4 view, mat4x4 projection)
 {
   JoltDebugRenderer *debug_renderer = memory->physics->debug_renderer;
-  debug_renderer->Clear();
-  memory->physics->physics_system->DrawBodies({.mDrawShapeWireframe = true}, debug_renderer);
+  DebugDrawResources *resources = memory->physics->debug_draw_resources;
+  GraphicsAPI *gfx = memory->gfx;
+  Arena *arena = memory->arena;
+  u32 instance_count = debug_renderer->instance_count();
+  if (instance_count == 0)
+    return;
+
+  u32 key_count = debug_renderer->batch_count * JoltDebugRenderer::DRAW_MODE_COUNT;
+  if (key_count > resources->key_capacity)
+  {
+    resources->key_capacity = key_count * 2;
+    resources->key_offsets = push_array_no_zero(arena, u32, resources->key_capacity);
+    resources->key_counts = push_array_no_zero(arena, u32, resources->key_capacity);
+  }
 
-  if (debug_renderer->vertex_count == 0)
+  // Instances per key over every thread's chunk
+  memset(resources->key_counts, 0, key_count * sizeof(u32));
+  for (u32 c = 0; c < debug_renderer->chunk_count; ++c)
+    for (JoltDebugBlock *block = debug_renderer->chunks[c].instances.first; block; block = block->next)
+    {
+      JoltDebugRenderer::InstanceRecord *records = (JoltDebugRenderer::InstanceRecord *)(block + 1);
+      for (u32 i = 0; i < block->count; ++i)
+        resources->key_counts[records[i].key]++;
+    }
+
+  // Prefix sums per key, and a Mesh for every batch drawn for the first time
+  u32 offset = 0;
+  for (u32 key = 0; key < key_count; ++key)
+  {
+    resources->key_offsets[key] = offset;
+    u32 count = resources->key_counts[key];
+    offset += count;
+
+    JoltDebugBatch *batch = debug_renderer->batches[key / JoltDebugRenderer::DRAW_MODE_COUNT];
+    if (count == 0 || batch->mesh)
+      continue;
+    Vertex *vertex = push_struct(arena, Vertex);
+    *vertex = {batch->positions, batch->normals, batch->colors};
+    batch->mesh = new (push_struct(arena, Mesh)) Mesh();
+    batch->mesh->create(arena, vertex, batch->vertex_count, batch->indices, batch->index_count, gfx);
+    gfx->bind_vertex_array(batch->mesh->vao);
+    for (s32 c = 0; c < 5; ++c)
+    {
+      gfx->enable_vertex_attrib(3 + c);
+      gfx->vertex_attrib_divisor(3 + c, 1);
+    }
+    gfx->bind_vertex_array(nullptr);
+  }
+
+  u32 stride = sizeof(JoltDebugRenderer::Instance);
+  JoltDebugRenderer::Instance *mapped = (JoltDebugRenderer::Instance *)gfx->stream_buffer_begin(resources->instance_stream, (size_t)instance_count * stride);
+  if (!mapped)
+  {
+    gfx->stream_buffer_end(resources->instance_stream, 0);
     return;
-  DebugLineResources *resources = memory->physics->debug_line_resources;
-  GraphicsAPI *gfx = memory->gfx;
+  }
+  for (u32 c = 0; c < debug_renderer->chunk_count; ++c)
+    for (JoltDebugBlock *block = debug_renderer->chunks[c].instances.first; block; block = block->next)
+    {
+      JoltDebugRenderer::InstanceRecord *records = (JoltDebugRenderer::InstanceRecord *)(block + 1);
+      for (u32 i = 0; i < block->count; ++i)
+        mapped[resources->key_offsets[records[i].key]++] = records[i].instance;
+    }
+  size_t base = gfx->stream_buffer_end(resources->instance_stream, (size_t)instance_count * stride);
 
-  gfx->use_program(resources->shader);
-  gfx->bind_vertex_array(resources->vao);
-  gfx->update_buffer_data(resources->vbo, debug_renderer->vertices, debug_renderer->vertex_count * sizeof(JoltDebugRenderer::Vertex));
+  Shader *shader = resources->instanced_shader;
+  vec3 light_pos = {8.0f, 5.0f, 8.0f};
+  shader->use(gfx);
+  shader->set_mat4(gfx, "view", (const r32 *)view);
+  shader->set_mat4(gfx, "projection", (const r32 *)projection);
+  shader->set_vec3(gfx, "light_pos", light_pos);
+  shader->set_vec3(gfx, "view_pos", memory->camera);
 
-  gfx->set_mat4(resources->shader, "view", (const r32 *)view);
-  gfx->set_mat4(resources->shader, "projection", (const r32 *)projection);
+  // key_offsets now hold each group's end. The instance attributes follow the group
+  gfx->bind_stream_buffer(resources->instance_stream);
+  for (u32 key = 0; key < key_count; ++key)
+  {
+    u32 count = resources->key_counts[key];
+    if (count == 0)
+      continue;
+    Mesh *mesh = debug_renderer->batches[key / JoltDebugRenderer::DRAW_MODE_COUNT]->mesh;
+    size_t first = base + (size_t)(resources->key_offsets[key] - count) * stride;
 
-  gfx->disable_depth_test();
-  gfx->set_line_width(2.0f);
+    gfx->bind_vertex_array(mesh->vao);
+    for (s32 c = 0; c < 4; ++c)
+      gfx->vertex_attrib_pointer(3 + c, 4, stride, first + offsetof(JoltDebugRenderer::Instance, model) + c * 4 * sizeof(r32));
+    gfx->vertex_attrib_format_pointer(7, 4, VERTEX_ATTRIB_UNORM8, stride, first + offsetof(JoltDebugRenderer::Instance, color));
 
-  gfx->draw_line_arrays(0, debug_renderer->vertex_count);
+    // Wireframes are an overlay like the lines, solid shapes are depth tested
+    bool wireframe = key % JoltDebugRenderer::DRAW_MODE_COUNT == JoltDebugRenderer::DRAW_WIREFRAME;
+    if (wireframe)
+      gfx->disable_depth_test();
+    else
+      gfx->enable_depth_test();
+    gfx->set_wireframe(wireframe);
+    mesh->draw_instanced(gfx, (s32)count);
+  }
+  gfx->set_wireframe(false);
   gfx->enable_depth_test();
 }
 
+static bool debug_shape_primed(const DebugDrawResources *resources, const JPH::Shape *shape)
+{
+  if (resources->primed_count == 0)
+    return false;
+  u32 mask = resources->primed_capacity - 1;
+  for (u32 i = (u32)(((uintptr_t)shape >> 4) * 0x9E3779B1u) & mask; resources->primed_shapes[i]; i = (i + 1) & mask)
+    if (resources->primed_shapes[i] == shape)
+      return true;
+  return false;
+}
+
+// The table holds at least twice max_bodies, every body adds at most its one root shape
+static void debug_shape_prime(DebugDrawResources *resources, const JPH::Shape *shape)
+{
+  if (debug_shape_primed(resources, shape) || 2 * (resources->primed_count + 1) > resources->primed_capacity)
+    return;
+
+  u32 mask = resources->primed_capacity - 1;
+  u32 i = (u32)(((uintptr_t)shape >> 4) * 0x9E3779B1u) & mask;
+  while (resources->primed_shapes[i])
+    i = (i + 1) & mask;
+  resources->primed_shapes[i] = shape;
+  resources->primed_count++;
+}
+
+// What BodyManager::Draw does per body: wireframe shape, colored by motion type and sleep
+// state like the serial path's EShapeColor::SleepColor
+static void draw_debug_body(JoltDebugRenderer *debug_renderer, const JPH::Body *body)
+{
+  JPH::Color color = JPH::Color::sGrey;
+  if (body->IsKinematic())
+    color = JPH::Color::sGreen;
+  else if (body->IsDynamic())
+    color = body->IsActive() ? JPH::Color::sYellow : JPH::Color::sRed;
+  body->GetShape()->Draw(debug_renderer, body->GetCenterOfMassTransform(), JPH::Vec3::sReplicate(1.0f), color, false, true);
+}
+
+// DrawBodies split into body ranges on the job system, each thread drawing into its own
+// chunk. Shape::Draw creates a shape's debug geometry on first use without a lock, so bodies
+// whose shape was never drawn are deferred and drawn here on the calling thread afterwards.
+static void draw_bodies_parallel(GameMemory *memory)
+{
+  PhysicsState *physics = memory->physics;
+  JoltDebugRenderer *debug_renderer = physics->debug_renderer;
+  DebugDrawResources *resources = physics->debug_draw_resources;
+  const DebugDrawFilter *filter = physics->debug_draw_filter;
+  const JPH::BodyLockInterfaceNoLock &lock_interface = physics->physics_system->GetBodyLockInterfaceNoLock();
+  JobSystemWorkStealing *job_system = physics->job_system;
+
+  JPH::BodyIDVector &ids = *resources->body_ids;
+  physics->physics_system->GetBodies(ids);
+
+  auto draw_range = [&](u32 begin, u32 end)
+  {
+    JoltDebugChunk *chunk = &debug_renderer->chunks[job_system->thread_slot()];
+    JoltDebugRenderer::tls_chunk = chunk;
+    for (u32 i = begin; i < end; ++i)
+    {
+      const JPH::Body *body = lock_interface.TryGetBody(ids[i]);
+      if (!body || !filter->ShouldDraw(*body))
+        continue;
+      if (debug_shape_primed(resources, body->GetShape()))
+        draw_debug_body(debug_renderer, body);
+      else
+        *(u32 *)jolt_debug_block_push(chunk->arena, &chunk->deferred, sizeof(u32), 1) = i;
+    }
+    JoltDebugRenderer::tls_chunk = nullptr;
+  };
+  job_system->parallel_for("DebugDrawBodies", (u32)ids.size(), 256, draw_range);
+
+  JoltDebugRenderer::tls_chunk = &debug_renderer->chunks[0];
+  for (u32 c = 0; c < debug_renderer->chunk_count; ++c)
+    for (JoltDebugBlock *block = debug_renderer->chunks[c].deferred.first; block; block = block->next)
+    {
+      u32 *deferred = (u32 *)(block + 1);
+      for (u32 k = 0; k < block->count; ++k)
+      {
+        const JPH::Body *body = lock_interface.TryGetBody(ids[deferred[k]]);
+        if (!body)
+          continue;
+        draw_debug_body(debug_renderer, body);
+        debug_shape_prime(resources, body->GetShape());
+      }
+    }
+  JoltDebugRenderer::tls_chunk = nullptr;
+}
+
+void draw_physics(GameMemory *memory, mat4x4 view, mat4x4 projection)
+{
+  PROFILE_SCOPE("draw_physics");
+  JoltDebugRenderer *debug_renderer = memory->physics->debug_renderer;
+  DebugDrawResources *resources = memory->physics->debug_draw_resources;
+  GraphicsAPI *gfx = memory->gfx;
+  PhysicsConfig *config = &memory->physics->config;
+  DebugDrawFilter *filter = memory->physics->debug_draw_filter;
+  u32 stride = sizeof(JoltDebugRenderer::Vertex);
+
+  debug_renderer->BeginGeometry(memory->camera);
+  filter->begin_frame(view, projection, memory->camera, config->debug_draw_distance, config->debug_draw_active_only);
+
+  s32 vertex_count;
+  size_t offset;
+  if (config->debug_draw_parallel)
+  {
+    draw_bodies_parallel(memory);
+
+    // The line count is known now, the chunks are concatenated into an exactly sized region
+    vertex_count = (s32)debug_renderer->chunk_vertex_count();
+    u8 *lines = (u8 *)gfx->stream_buffer_begin(resources->stream, (size_t)vertex_count * stride);
+    if (!lines)
+      vertex_count = 0;
+    for (u32 c = 0; c < debug_renderer->chunk_count && lines; ++c)
+      for (JoltDebugBlock *block = debug_renderer->chunks[c].lines.first; block; block = block->next)
+      {
+        memcpy(lines, block + 1, (size_t)block->count * stride);
+        lines += (size_t)block->count * stride;
+      }
+    offset = gfx->stream_buffer_end(resources->stream, (size_t)vertex_count * stride);
+  }
+  else
+  {
+    // DrawLine writes into the mapped region, nothing is copied on the CPU
+    void *lines = gfx->stream_buffer_begin(resources->stream, (size_t)resources->vertex_capacity * stride);
+    debug_renderer->BeginLines((JoltDebugRenderer::Vertex *)lines, resources->vertex_capacity);
+    JPH::BodyManager::DrawSettings settings = {.mDrawShapeWireframe = true, .mDrawShapeColor = JPH::BodyManager::EShapeColor::SleepColor};
+    memory->physics->physics_system->DrawBodies(settings, debug_renderer, filter);
+
+    // Lines that did not fit are dropped this frame, the next region is big enough
+    vertex_count = debug_renderer->written_count();
+    if (debug_renderer->vertex_count > resources->vertex_capacity)
+      resources->vertex_capacity = debug_renderer->vertex_count + debug_renderer->vertex_count / 4;
+
+    offset = gfx->stream_buffer_end(resources->stream, (size_t)vertex_count * stride);
+  }
+
+  draw_debug_geometry(memory, view, projection);
+
+  if (vertex_count > 0)
+  {
+    gfx->disable_depth_test();
+    // The region moves every frame, so the attribute offsets do too
+    gfx->bind_vertex_array(resources->vao);
+    gfx->bind_stream_buffer(resources->stream);
+    gfx->vertex_attrib_pointer(0, 3, stride, offset + offsetof(JoltDebugRenderer::Vertex, pos));
+    gfx->vertex_attrib_format_pointer(1, 4, VERTEX_ATTRIB_UNORM8, stride, offset + offsetof(JoltDebugRenderer::Vertex, color));
+
+    gfx->use_program(resources->shader);
+    gfx->set_mat4(resources->shader, "view", (const r32 *)view);
+    gfx->set_mat4(resources->shader, "projection", (const r32 *)projection);
+    gfx->set_line_width(2.0f);
+    gfx->draw_line_arrays(0, vertex_count);
+    gfx->enable_depth_test();
+  }
+}
+
+void step_physics(PhysicsState *physics, r32 dt)
+{
+  PROFILE_SCOPE("step_physics");
+  physics->temp_allocator->Clear();
+  physics->physics_system->Update(dt, physics->config.collision_steps, physics->temp_allocator, physics->job_system);
+}
+
+static void write_pose(TransformSoA *t, u32 i, const JPH::Body *body)
+{
+  JPH::RVec3 position = body->GetPosition();
+  JPH::Quat rotation = body->GetRotation();
+  t->px[i] = (r32)position.GetX();
+  t->py[i] = (r32)position.GetY();
+  t->pz[i] = (r32)position.GetZ();
+  t->qx[i] = rotation.GetX();
+  t->qy[i] = rotation.GetY();
+  t->qz[i] = rotation.GetZ();
+  t->qw[i] = rotation.GetW();
+}
+
+static void settle_pose(PoseBuffer *out, u32 i)
+{
+  out->prev.px[i] = out->curr.px[i];
+  out->prev.py[i] = out->curr.py[i];
+  out->prev.pz[i] = out->curr.pz[i];
+  out->prev.qx[i] = out->curr.qx[i];
+  out->prev.qy[i] = out->curr.qy[i];
+  out->prev.qz[i] = out->curr.qz[i];
+  out->prev.qw[i] = out->curr.qw[i];
+}
+
+static void mark_pose_dirty(PoseBuffer *out, u32 i)
+{
+  if (i < out->dirty_begin)
+    out->dirty_begin = i;
+  if (i + 1 > out->dirty_end)
+    out->dirty_end = i + 1;
+}
+
+// After a step: walk only the active bodies (no locks, the step is finished) and move
+// their poses to curr, keeping the old curr as prev. Bodies synced last time but now
+// asleep get prev = curr once, so they stop interpolating.
+void sync_active_poses(PhysicsState *physics, PoseBuffer *out)
+{
+  PROFILE_SCOPE("sync_active_poses");
+  const JPH::BodyLockInterfaceNoLock &lock_interface = physics->physics_system->GetBodyLockInterfaceNoLock();
+
+  for (u32 k = 0; k < physics->synced_count; ++k)
+  {
+    u32 i = physics->synced_poses[k];
+    settle_pose(out, i);
+    mark_pose_dirty(out, i);
+  }
+
+  u32 synced_count = 0;
+  u32 *synced = physics->synced_scratch;
+
+  u32 active_count = physics->physics_system->GetNumActiveBodies(JPH::EBodyType::RigidBody);
+  const JPH::BodyID *active = physics->physics_system->GetActiveBodiesUnsafe(JPH::EBodyType::RigidBody);
+  for (u32 k = 0; k < active_count; ++k)
+  {
+    const JPH::Body *body = lock_interface.TryGetBody(active[k]);
+    if (!body || body->GetUserData() >= out->count)
+      continue;
+
+    u32 i = (u32)body->GetUserData();
+    settle_pose(out, i);
+    write_pose(&out->curr, i, body);
+    mark_pose_dirty(out, i);
+    synced[synced_count++] = i;
+  }
+
+  physics->synced_scratch = physics->synced_poses;
+  physics->synced_poses = synced;
+  physics->synced_count = synced_count;
+}
+
+static TransformSoA push_transforms(Arena *arena, u32 stride)
+{
+  r32 *block = (r32 *)arena_push(arena, 7 * stride * sizeof(r32), 32, 1);
+  TransformSoA t = {};
+  t.px = block + 0 * stride;
+  t.py = block + 1 * stride;
+  t.pz = block + 2 * stride;
+  t.qx = block + 3 * stride;
+  t.qy = block + 4 * stride;
+  t.qz = block + 5 * stride;
+  t.qw = block + 6 * stride;
+  return t;
+}
+
+static PoseBuffer push_pose_buffer(Arena *arena, u32 count)
+{
+  PoseBuffer buffer = {};
+  buffer.count = count;
+  buffer.stride = (count + 7) & ~7u; // streams stay 32-byte aligned
+  buffer.prev = push_transforms(arena, buffer.stride);
+  buffer.curr = push_transforms(arena, buffer.stride);
+  buffer.alpha = 1.0f;
+  buffer.dirty_begin = 0;
+  buffer.dirty_end = count;
+  buffer.sequence = 1; // renderer starts at 0, first frame takes the full range
+  return buffer;
+}
+
+static void copy_pose_buffer(PoseBuffer *dst, const PoseBuffer *src)
+{
+  if (dst == src)
+    return;
+  memcpy(dst->prev.px, src->prev.px, 7 * src->stride * sizeof(r32));
+  memcpy(dst->curr.px, src->curr.px, 7 * src->stride * sizeof(r32));
+  dst->alpha = src->alpha;
+  dst->dirty_begin = src->dirty_begin;
+  dst->dirty_end = src->dirty_end;
+  dst->sequence = src->sequence;
+}
+
+// Lay out all RenderContexts in one PoseBuffer, tag each body with its pose index
+// (body user data) and fill prev/curr with the spawn poses
+void init_body_poses(GameMemory *memory)
+{
+  PhysicsState *physics = memory->physics;
+  const JPH::BodyLockInterfaceNoLock &lock_interface = physics->physics_system->GetBodyLockInterfaceNoLock();
+
+  u32 count = 0;
+  for (int i = 0; i < memory->render_context_count; ++i)
+  {
+    memory->render_contexts[i].pose_base = count;
+    count += memory->render_contexts[i].objects_count;
+  }
+
+  memory->pose_count = count;
+  memory->poses = push_struct(memory->arena, PoseBuffer);
+  *memory->poses = push_pose_buffer(memory->arena, count);
+  memory->models = (mat4x4 *)arena_push(memory->arena, sizeof(mat4x4) * memory->poses->stride, 32, true);
+  physics->synced_poses = push_array(memory->arena, u32, count);
+  physics->synced_scratch = push_array(memory->arena, u32, count);
+  physics->synced_count = 0;
+
+  for (int i = 0; i < memory->render_context_count; ++i)
+  {
+    RenderContext *ctx = &memory->render_contexts[i];
+    for (int j = 0; j < ctx->objects_count; ++j)
+    {
+      JPH::Body *body = lock_interface.TryGetBody(*ctx->objects[j].body_id);
+      if (!body)
+        continue;
+      u32 p = ctx->pose_base + j;
+      body->SetUserData(p);
+      write_pose(&memory->poses->curr, p, body);
+      settle_pose(memory->poses, p);
+    }
+  }
+}
+
+// Advance the simulation by one frame of `dt` and leave the poses around the last step in `out`
+void simulate_physics_frame(GameMemory *memory, PoseBuffer *out, r32 dt)
+{
+  PROFILE_SCOPE("simulate_physics_frame");
+  PhysicsState *physics = memory->physics;
+
+  u32 steps = 1;
+  r32 step = dt;
+  if (physics->config.fixed_hz > 0.0f)
+  {
+    step = 1.0f / physics->config.fixed_hz;
+    physics->accumulator += dt;
+
+    steps = (u32)(physics->accumulator / step);
+    if (steps > physics->config.max_substeps)
+    {
+      // Too far behind: drop whole steps instead of spiralling
+      steps = physics->config.max_substeps;
+      physics->accumulator = fmodf(physics->accumulator, step) + steps * step;
+    }
+  }
+
+  if (steps > 0)
+  {
+    out->dirty_begin = out->count;
+    out->dirty_end = 0;
+    for (u32 i = 0; i < steps; ++i)
+    {
+      step_physics(physics, step);
+      sync_active_poses(physics, out);
+    }
+    out->sequence++;
+  }
+
+  if (physics->config.fixed_hz > 0.0f)
+  {
+    physics->accumulator -= steps * step;
+    if (physics->accumulator < 0.0f)
+      physics->accumulator = 0.0f;
+    out->alpha = physics->accumulator / step;
+  }
+  else
+    out->alpha = 1.0f;
+}
+
+static void physics_pipeline_main(GameMemory *memory)
+{
+  PhysicsPipeline *pipeline = memory->physics->pipeline;
+  u32 seen = pipeline->done.load(std::memory_order_acquire);
+  profiler_set_thread_name("physics");
+
+  for (;;)
+  {
+    pipeline->kick.wait(seen, std::memory_order_acquire);
+    seen = pipeline->kick.load(std::memory_order_acquire);
+    if (!pipeline->running.load(std::memory_order_acquire))
+      break;
+
+    r32 dt = pipeline->pending_dt.exchange(0.0f, std::memory_order_acq_rel);
+    simulate_physics_frame(memory, &pipeline->sim, dt);
+
+    copy_pose_buffer(&pipeline->frames[pipeline->back], &pipeline->sim);
+    pipeline->back = pipeline->ready.exchange(pipeline->back | PIPELINE_FRESH, std::memory_order_acq_rel) & ~PIPELINE_FRESH;
+
+    pipeline->done.store(seen, std::memory_order_release);
+    pipeline->done.notify_all();
+  }
+}
+
+// Needs init_body_poses() first. Safe to call again after physics_pipeline_stop().
+void physics_pipeline_start(GameMemory *memory)
+{
+  PhysicsState *physics = memory->physics;
+  if (!physics->pipeline)
+  {
+    physics->pipeline = new (push_struct(memory->arena, PhysicsPipeline)) PhysicsPipeline();
+    for (int i = 0; i < 3; ++i)
+      physics->pipeline->frames[i] = push_pose_buffer(memory->arena, memory->pose_count);
+    physics->pipeline->sim = push_pose_buffer(memory->arena, memory->pose_count);
+  }
+
+  PhysicsPipeline *pipeline = physics->pipeline;
+  copy_pose_buffer(&pipeline->sim, memory->poses);
+  for (int i = 0; i < 3; ++i)
+    copy_pose_buffer(&pipeline->frames[i], memory->poses);
+
+  pipeline->back = 0;
+  pipeline->front = 1;
+  pipeline->ready.store(2, std::memory_order_relaxed);
+  pipeline->pending_dt.store(0.0f, std::memory_order_relaxed);
+  pipeline->done.store(pipeline->kick.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  pipeline->running.store(true, std::memory_order_release);
+
+  memory->poses = &pipeline->frames[pipeline->front];
+  pipeline->thread = std::thread(physics_pipeline_main, memory);
+}
+
+// Block until the physics thread has finished every kicked frame
+void physics_pipeline_wait_idle(PhysicsPipeline *pipeline)
+{
+  u32 target = pipeline->kick.load(std::memory_order_acquire);
+  u32 done = pipeline->done.load(std::memory_order_acquire);
+  while (done != target)
+  {
+    pipeline->done.wait(done, std::memory_order_acquire);
+    done = pipeline->done.load(std::memory_order_acquire);
+  }
+}
+
+void physics_pipeline_stop(GameMemory *memory)
+{
+  PhysicsPipeline *pipeline = memory->physics->pipeline;
+  if (!pipeline || !pipeline->running.load(std::memory_order_acquire))
+    return;
+
+  physics_pipeline_wait_idle(pipeline);
+  pipeline->running.store(false, std::memory_order_release);
+  pipeline->kick.fetch_add(1, std::memory_order_acq_rel);
+  pipeline->kick.notify_one();
+  pipeline->thread.join();
+
+  // Keep rendering from the last published frame
+  u32 ready = pipeline->ready.load(std::memory_order_acquire);
+  if (ready & PIPELINE_FRESH)
+    pipeline->front = ready & ~PIPELINE_FRESH;
+  memory->poses = &pipeline->frames[pipeline->front];
+}
+
+// Main thread: queue a frame of `dt` for the physics thread, then pick up the newest published poses
+void physics_pipeline_frame(GameMemory *memory, r32 dt)
+{
+  PhysicsPipeline *pipeline = memory->physics->pipeline;
+
+  pipeline->pending_dt.fetch_add(dt, std::memory_order_acq_rel);
+  pipeline->kick.fetch_add(1, std::memory_order_acq_rel);
+  pipeline->kick.notify_one();
+
+  if (pipeline->ready.load(std::memory_order_acquire) & PIPELINE_FRESH)
+  {
+    pipeline->front = pipeline->ready.exchange(pipeline->front, std::memory_order_acq_rel) & ~PIPELINE_FRESH;
+    memory->poses = &pipeline->frames[pipeline->front];
+  }
+}
+
+bool physics_pipeline_running(PhysicsState *physics)
+{
+  return physics->pipeline && physics->pipeline->running.load(std::memory_order_acquire);
+}
+
+// Rough per-item costs used for budget reports, not exact Jolt internals
+static const u64 PHYSICS_BYTES_PER_BODY = sizeof(JPH::Body) + sizeof(JPH::MotionProperties) + 128; // + id/ptr tables, broadphase nodes
+static const u64 PHYSICS_BYTES_PER_BODY_PAIR = 64;                                                   // pair + manifold cache entry
+static const u64 PHYSICS_BYTES_PER_CONTACT = 512;                                                    // ContactConstraint + points
+static const u64 PHYSICS_TEMP_BYTES_PER_BODY = 512;                                                  // islands, active lists, pair queues
+static const u64 PHYSICS_TEMP_BYTES_PER_CONTACT = 256;                                               // constraint solver scratch
+
+// Scale every budget from the number of bodies a scene needs
+PhysicsConfig physics_config_for_bodies(u32 bodies)
+{
+  PhysicsConfig config = {};
+  u32 max_bodies = (bodies + 1023) & ~1023u;
+  config.max_bodies = max_bodies > 1024 ? max_bodies : 1024;
+  config.max_body_pairs = config.max_bodies * 4;
+  config.max_contact_constraints = config.max_bodies * 2;
+  u64 temp_size = (u64)config.max_bodies * PHYSICS_TEMP_BYTES_PER_BODY + (u64)config.max_contact_constraints * PHYSICS_TEMP_BYTES_PER_CONTACT;
+  config.temp_allocator_size = temp_size > MB(10) ? temp_size : MB(10);
+  return config;
+}
+
+// Plain "key = value" lines, '#' starts a comment. Missing file or keys keep the defaults.
+//   max_bodies = 102400
+//   temp_allocator_size = 134217728
+PhysicsConfig physics_config_load(const char *path)
+{
+  PhysicsConfig config = {};
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return config;
+
+  char line[256];
+  while (fgets(line, sizeof(line), file))
+  {
+    char key[64];
+    r64 value;
+    if (line[0] == '#' || sscanf(line, " %63[a-z_] = %lf", key, &value) != 2)
+      continue;
+
+    if (strcmp(key, "max_bodies") == 0)
+      config.max_bodies = (u32)value;
+    else if (strcmp(key, "num_body_mutexes") == 0)
+      config.num_body_mutexes = (u32)value;
+    else if (strcmp(key, "max_body_pairs") == 0)
+      config.max_body_pairs = (u32)value;
+    else if (strcmp(key, "max_contact_constraints") == 0)
+      config.max_contact_constraints = (u32)value;
+    else if (strcmp(key, "temp_allocator_size") == 0)
+      config.temp_allocator_size = (u64)value;
+    else if (strcmp(key, "max_jobs") == 0)
+      config.max_jobs = (u32)value;
+    else if (strcmp(key, "max_barriers") == 0)
+      config.max_barriers = (u32)value;
+    else if (strcmp(key, "num_threads") == 0)
+      config.num_threads = (s32)value;
+    else if (strcmp(key, "worker_first_core") == 0)
+      config.worker_first_core = (s32)value;
+    else if (strcmp(key, "main_thread_core") == 0)
+      config.main_thread_core = (s32)value;
+    else if (strcmp(key, "worker_nice") == 0)
+      config.worker_nice = (s32)value;
+    else if (strcmp(key, "pool_allocator") == 0)
+      config.pool_allocator = value != 0.0;
+    else if (strcmp(key, "debug_draw_distance") == 0)
+      config.debug_draw_distance = (r32)value;
+    else if (strcmp(key, "debug_draw_active_only") == 0)
+      config.debug_draw_active_only = value != 0.0;
+    else if (strcmp(key, "debug_draw_parallel") == 0)
+      config.debug_draw_parallel = value != 0.0;
+    else if (strcmp(key, "profile_report") == 0)
+      config.profile_report = value != 0.0;
+    else if (strcmp(key, "fixed_hz") == 0)
+      config.fixed_hz = (r32)value;
+    else if (strcmp(key, "max_substeps") == 0)
+      config.max_substeps = (u32)value;
+    else if (strcmp(key, "collision_steps") == 0)
+      config.collision_steps = (u32)value;
+    else
+      fprintf(stderr, "%s: unknown key '%s'\n", path, key);
+  }
+  fclose(file);
+  printf("Physics config loaded from %s\n", path);
+  return config;
+}
+
+// Per-worker share of wall time spent in jobs since the last reset, for tuning pinning and thread counts
+void physics_report_workers(PhysicsState *physics, bool reset)
+{
+  JobSystemWorkStealing *jobs = physics->job_system;
+  JobWorkerStats stats[64];
+  u32 count = jobs->read_worker_stats(stats, sizeof(stats) / sizeof(stats[0]), reset);
+  for (u32 i = 0; i < count; ++i)
+    printf("worker %2u core %3d busy %5.1f%% jobs %8llu steals %8llu\n", i, stats[i].core,
+           stats[i].busy_fraction * 100.0, (unsigned long long)stats[i].jobs, (unsigned long long)stats[i].steals);
+}
+
+// Jolt heap usage by size class (pool allocator only)
+void physics_report_allocations(PhysicsState *physics)
+{
+  if (!physics->config.pool_allocator)
+    return;
+
+  JoltPoolStats stats;
+  jolt_pool_read_stats(&stats);
+  for (u32 i = 0; i < JOLT_POOL_CLASSES; ++i)
+  {
+    const JoltPoolClassStats *c = &stats.classes[i];
+    if (c->allocs == 0)
+      continue;
+    printf("jolt pool %6u B: live %8llu allocs %10llu reserved %8.2f MB\n", c->block_size,
+           (unsigned long long)(c->allocs - c->frees), (unsigned long long)c->allocs, c->reserved_bytes / (r64)MB(1));
+  }
+  printf("jolt pool large: live %llu (%.2f MB) allocs %llu, pools reserved %.2f MB\n",
+         (unsigned long long)(stats.large_allocs - stats.large_frees), stats.large_live_bytes / (r64)MB(1),
+         (unsigned long long)stats.large_allocs, stats.reserved_bytes / (r64)MB(1));
+}
+
+// Last debug draw frame: how many bodies the filter tested and why the rest were skipped
+void physics_report_debug_draw(PhysicsState *physics)
+{
+  DebugDrawFilter *filter = physics->debug_draw_filter;
+  if (!filter || !physics->debug_draw_enabled)
+    return;
+  u32 tested = filter->tested.load(std::memory_order_relaxed);
+  u32 frustum = filter->culled_frustum.load(std::memory_order_relaxed);
+  u32 distance = filter->culled_distance.load(std::memory_order_relaxed);
+  u32 inactive = filter->culled_inactive.load(std::memory_order_relaxed);
+  printf("debug draw: bodies=%u drawn=%u culled frustum=%u distance=%u inactive=%u\n", tested,
+         tested - frustum - distance - inactive, frustum, distance, inactive);
+}
+
+// Startup check: can the configured budgets hold the requested scene? Also reports the footprint.
+bool physics_check_budget(PhysicsState *physics, u32 requested_bodies)
+{
+  const PhysicsConfig *config = &physics->config;
+  bool ok = true;
+
+  if (requested_bodies > config->max_bodies)
+  {
+    fprintf(stderr, "Physics budget: scene needs %u bodies, max_bodies is %u\n", requested_bodies, config->max_bodies);
+    ok = false;
+  }
+  if (config->max_body_pairs < requested_bodies)
+    fprintf(stderr, "Physics budget: max_body_pairs %u < %u bodies, contacts may be dropped\n", config->max_body_pairs, requested_bodies);
+  if (config->max_contact_constraints < requested_bodies)
+    fprintf(stderr, "Physics budget: max_contact_constraints %u < %u bodies, contacts may be dropped\n", config->max_contact_constraints, requested_bodies);
+  if (config->temp_allocator_size < (u64)requested_bodies * PHYSICS_TEMP_BYTES_PER_BODY)
+    fprintf(stderr, "Physics budget: temp allocator %.1f MB is likely too small for %u bodies\n",
+            config->temp_allocator_size / (r64)MB(1), requested_bodies);
+
+  u64 body_bytes = (u64)config->max_bodies * PHYSICS_BYTES_PER_BODY;
+  u64 pair_bytes = (u64)config->max_body_pairs * PHYSICS_BYTES_PER_BODY_PAIR;
+  u64 contact_bytes = (u64)config->max_contact_constraints * PHYSICS_BYTES_PER_CONTACT;
+  u64 total_bytes = body_bytes + pair_bytes + contact_bytes + config->temp_allocator_size;
+
+  printf("Physics budget: bodies %u/%u, pairs %u, contacts %u, jobs %u, threads %d\n",
+         requested_bodies, config->max_bodies, config->max_body_pairs, config->max_contact_constraints,
+         config->max_jobs, physics->job_system->GetMaxConcurrency());
+  printf("Physics memory (est.): bodies %.1f MB, pairs %.1f MB, contacts %.1f MB, temp %.1f MB, total %.1f MB\n",
+         body_bytes / (r64)MB(1), pair_bytes / (r64)MB(1), contact_bytes / (r64)MB(1),
+         config->temp_allocator_size / (r64)MB(1), total_bytes / (r64)MB(1));
+  return ok;
+}
+
+void layer_registry_init(LayerRegistry *registry, const LayerDesc *layers, u32 layer_count,
+                         const char *const *broadphase_names, u32 broadphase_layer_count)
+{
+  assert(layer_count <= MAX_OBJECT_LAYERS && broadphase_layer_count <= MAX_OBJECT_LAYERS);
+  *registry = {};
+  registry->broadphase_layer_count = broadphase_layer_count;
+  for (u32 b = 0; b < broadphase_layer_count; ++b)
+    registry->broadphase_names[b] = broadphase_names[b];
+
+  for (u32 i = 0; i < layer_count; ++i)
+  {
+    const LayerDesc *desc = &layers[i];
+    assert(desc->layer < MAX_OBJECT_LAYERS && (JPH::BroadPhaseLayer::Type)desc->broadphase < broadphase_layer_count);
+    registry->object_layer_count = Max(registry->object_layer_count, (u32)desc->layer + 1);
+    registry->broadphase[desc->layer] = desc->broadphase;
+    registry->names[desc->layer] = desc->name;
+    registry->collides[desc->layer] |= desc->collides;
+  }
+
+  // Mirror so a pair only needs to be listed on one side
+  for (u32 i = 0; i < MAX_OBJECT_LAYERS; ++i)
+    for (u32 j = 0; j < MAX_OBJECT_LAYERS; ++j)
+      if ((registry->collides[i] >> j) & 1)
+        registry->collides[j] |= LAYER_BIT(i);
+
+  for (u32 i = 0; i < registry->object_layer_count; ++i)
+    for (u32 j = 0; j < registry->object_layer_count; ++j)
+      if ((registry->collides[i] >> j) & 1)
+        registry->collides_broadphase[i] |= LAYER_BIT((JPH::BroadPhaseLayer::Type)registry->broadphase[j]);
+}
+
+void layer_registry_init_default(LayerRegistry *registry)
+{
+  static const LayerDesc layers[] = {
+      {Layers::NON_MOVING, "static", BroadPhaseLayers::NON_MOVING, 0},
+      {Layers::MOVING, "moving", BroadPhaseLayers::MOVING,
+       LAYER_BIT(Layers::NON_MOVING) | LAYER_BIT(Layers::MOVING) | LAYER_BIT(Layers::DEBRIS) | LAYER_BIT(Layers::SENSOR) | LAYER_BIT(Layers::VEHICLE) | LAYER_BIT(Layers::PROJECTILE)},
+      {Layers::DEBRIS, "debris", BroadPhaseLayers::DEBRIS,
+       LAYER_BIT(Layers::NON_MOVING) | LAYER_BIT(Layers::DEBRIS) | LAYER_BIT(Layers::VEHICLE)},
+      {Layers::SENSOR, "sensor", BroadPhaseLayers::SENSOR,
+       LAYER_BIT(Layers::VEHICLE)},
+      {Layers::VEHICLE, "vehicle", BroadPhaseLayers::MOVING,
+       LAYER_BIT(Layers::NON_MOVING) | LAYER_BIT(Layers::VEHICLE) | LAYER_BIT(Layers::PROJECTILE)},
+      {Layers::PROJECTILE, "projectile", BroadPhaseLayers::MOVING,
+       LAYER_BIT(Layers::NON_MOVING)},
+  };
+  static const char *const broadphase_names[] = {"static", "moving", "debris", "sensor"};
+  static_assert(sizeof(layers) / sizeof(layers[0]) == Layers::NUM_LAYERS, "layer table out of date");
+  static_assert(sizeof(broadphase_names) / sizeof(broadphase_names[0]) == BroadPhaseLayers::NUM_LAYERS, "broadphase table out of date");
+  layer_registry_init(registry, layers, Layers::NUM_LAYERS, broadphase_names, BroadPhaseLayers::NUM_LAYERS);
+}
+
+// Creates the bodies on the job system, then inserts all of them into the broadphase in one
+// AddBodiesPrepare/Finalize pass. ids[i] stays invalid where creation failed (PhysicsSystem
+// full). Call outside of a physics step. Returns the number of bodies added.
+u32 physics_spawn_bodies(PhysicsState *physics, const JPH::BodyCreationSettings *settings, u32 count,
+                         JPH::BodyID *ids, JPH::EActivation activation)
+{
+  PROFILE_SCOPE("physics_spawn_bodies");
+  JPH::BodyInterface &body_interface = physics->physics_system->GetBodyInterface();
+
+  // Body construction (mass properties, allocation) runs in parallel. IDs are assigned
+  // serially in object order: Jolt is only deterministic when the same scene gets the same IDs
+  JPH::Array<JPH::Body *> bodies(count);
+  auto create_range = [&body_interface, settings, &bodies](u32 begin, u32 end)
+  {
+    for (u32 i = begin; i < end; ++i)
+      bodies[i] = body_interface.CreateBodyWithoutID(settings[i]);
+  };
+  physics->job_system->parallel_for("SpawnBodies", count, 1024, create_range);
+
+  for (u32 i = 0; i < count; ++i)
+  {
+    ids[i] = JPH::BodyID();
+    if (!bodies[i])
+      continue;
+    if (body_interface.AssignBodyID(bodies[i]))
+      ids[i] = bodies[i]->GetID();
+    else
+      body_interface.DestroyBodyWithoutID(bodies[i]);
+  }
+
+  // AddBodiesPrepare reorders its input, keep ids[] in object order
+  JPH::Array<JPH::BodyID> added;
+  added.reserve(count);
+  for (u32 i = 0; i < count; ++i)
+    if (!ids[i].IsInvalid())
+      added.push_back(ids[i]);
+  if (added.empty())
+    return 0;
+
+  JPH::BodyInterface::AddState state = body_interface.AddBodiesPrepare(added.data(), (s32)added.size());
+  body_interface.AddBodiesFinalize(added.data(), (s32)added.size(), state, activation);
+  return (u32)added.size();
+}
+
+ShapeCache *shape_cache_create(Arena *arena, u32 capacity)
+{
+  u32 pow2 = 16;
+  while (pow2 < capacity * 2) // keep load <= 1/2
+    pow2 <<= 1;
+
+  ShapeCache *cache = push_struct(arena, ShapeCache);
+  cache->capacity = pow2;
+  cache->keys = push_array(arena, ShapeKey, pow2);
+  cache->shapes = push_array(arena, JPH::RefConst<JPH::Shape>, pow2); // zeroed == null refs
+  return cache;
+}
+
+static u32 shape_key_hash(const ShapeKey &key)
+{
+  const u8 *bytes = (const u8 *)&key;
+  u32 hash = 2166136261u;
+  for (u32 i = 0; i < sizeof(ShapeKey); ++i)
+    hash = (hash ^ bytes[i]) * 16777619u;
+  return hash;
+}
+
+static u32 shape_cache_slot(const ShapeCache *cache, const ShapeKey &key)
+{
+  u32 mask = cache->capacity - 1;
+  u32 slot = shape_key_hash(key) & mask;
+  while (cache->shapes[slot] != nullptr && memcmp(&cache->keys[slot], &key, sizeof(ShapeKey)) != 0)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+const JPH::Shape *shape_cache_find(ShapeCache *cache, const ShapeKey &key)
+{
+  const JPH::Shape *shape = cache->shapes[shape_cache_slot(cache, key)];
+  if (shape)
+    cache->hits++;
+  else
+    cache->misses++;
+  return shape;
+}
+
+void shape_cache_insert(ShapeCache *cache, Arena *arena, const ShapeKey &key, const JPH::Shape *shape)
+{
+  if (!shape)
+    return;
+
+  if ((cache->count + 1) * 2 > cache->capacity)
+  {
+    // Old slots stay in the arena, their references are moved into the new table
+    ShapeKey *old_keys = cache->keys;
+    JPH::RefConst<JPH::Shape> *old_shapes = cache->shapes;
+    u32 old_capacity = cache->capacity;
+
+    cache->capacity = old_capacity * 2;
+    cache->keys = push_array(arena, ShapeKey, cache->capacity);
+    cache->shapes = push_array(arena, JPH::RefConst<JPH::Shape>, cache->capacity);
+    for (u32 i = 0; i < old_capacity; ++i)
+    {
+      if (old_shapes[i] == nullptr)
+        continue;
+      u32 slot = shape_cache_slot(cache, old_keys[i]);
+      cache->keys[slot] = old_keys[i];
+      cache->shapes[slot] = std::move(old_shapes[i]);
+    }
+  }
+
+  u32 slot = shape_cache_slot(cache, key);
+  if (cache->shapes[slot] == nullptr)
+    cache->count++;
+  cache->keys[slot] = key;
+  cache->shapes[slot] = shape;
+}
 
 void init_physics(GameMemory *memory)
 {
@@ -33,53 +923,75 @@ void init_physics(GameMemory *memory)
   Arena *arena = memory->arena;
 
   memory->physics = push_struct(arena, PhysicsState);
+  memory->physics->config = memory->physics_config ? *memory->physics_config : physics_config_load("physics.cfg");
+  const PhysicsConfig *config = &memory->physics->config;
   memory->physics->factory_instance = new (push_struct(arena, JPH::Factory)) JPH::Factory();
 
-  JPH::RegisterDefaultAllocator();
+  if (config->pool_allocator)
+    jolt_pool_register();
+  else
+    JPH::RegisterDefaultAllocator();
   JPH::Factory::sInstance = memory->physics->factory_instance;
   JPH::RegisterTypes();
 
-  memory->physics->temp_allocator = new (push_struct(arena, JoltTempArenaAllocator)) JoltTempArenaAllocator(arena, 10 * 1024 * 1024);
-  memory->physics->job_system = new (push_struct(arena, JPH::JobSystemThreadPool)) JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::thread::hardware_concurrency() - 1);
+  // Overflow blocks are pushed mid-step, possibly on the pipelined physics thread, so the
+  // temp allocator gets an arena of its own
+  Arena *temp_arena = arena_alloc(GB(16), KB(64), 0);
+  memory->physics->temp_allocator = new (push_struct(arena, JoltTempArenaAllocator)) JoltTempArenaAllocator(temp_arena, config->temp_allocator_size);
+  s32 num_threads = config->num_threads >= 0 ? config->num_threads : (s32)std::thread::hardware_concurrency() - 1;
+  memory->physics->job_system = new (push_struct(arena, JobSystemWorkStealing)) JobSystemWorkStealing(arena, config->max_jobs, config->max_barriers, num_threads,
+                                                                                                     {config->worker_first_core, config->main_thread_core, config->worker_nice});
 
-  memory->physics->broad_phase_layer_interface = new (push_struct(arena, BPLayerInterfaceImpl)) BPLayerInterfaceImpl();
-  memory->physics->object_vs_broadphase_filter = new (push_struct(arena, ObjectVsBroadPhaseLayerFilterImpl)) ObjectVsBroadPhaseLayerFilterImpl();
-  memory->physics->object_vs_object_filter = new (push_struct(arena, ObjectLayerPairFilterImpl)) ObjectLayerPairFilterImpl();
+  const LayerRegistry *layers = &memory->physics->layers;
+  layer_registry_init_default(&memory->physics->layers);
+  memory->physics->broad_phase_layer_interface = new (push_struct(arena, BPLayerInterfaceImpl)) BPLayerInterfaceImpl(layers);
+  memory->physics->object_vs_broadphase_filter = new (push_struct(arena, ObjectVsBroadPhaseLayerFilterImpl)) ObjectVsBroadPhaseLayerFilterImpl(layers);
+  memory->physics->object_vs_object_filter = new (push_struct(arena, ObjectLayerPairFilterImpl)) ObjectLayerPairFilterImpl(layers);
 
   // Create physics system
-  const u32 max_bodies = 1024;
-  const u32 num_body_mutexes = 0; // Auto-detect
-  const u32 max_body_pairs = 1024;
-  const u32 max_contact_constraints = 1024;
-
   memory->physics->physics_system = new (push_struct(arena, JPH::PhysicsSystem)) JPH::PhysicsSystem();
-  memory->physics->physics_system->Init(max_bodies, num_body_mutexes, max_body_pairs,
-                                        max_contact_constraints,
+  memory->physics->physics_system->Init(config->max_bodies, config->num_body_mutexes, config->max_body_pairs,
+                                        config->max_contact_constraints,
                                         *memory->physics->broad_phase_layer_interface,
                                         *memory->physics->object_vs_broadphase_filter,
                                         *memory->physics->object_vs_object_filter);
 
   memory->physics->physics_system->SetGravity(JPH::Vec3(0.0f, -9.81f, 0.0f));
+  memory->physics->shape_cache = shape_cache_create(arena, 64);
+
+  // Headless (bench): no GraphicsAPI, no debug draw
+  if (!gfx)
+    return;
 
   // --------------[ Jolt Debug Render ]-----------------
-  memory->physics->debug_renderer = new (push_struct(arena, JoltDebugRenderer)) JoltDebugRenderer();
-  memory->physics->debug_renderer->InitializeLines(arena);
+  // Batches come from their own arena, CreateTriangleBatch may run on any thread. One chunk
+  // per job worker plus one for the main thread
+  Arena *debug_arena = arena_alloc(GB(16), KB(64), 0);
+  u32 chunk_count = memory->physics->job_system->get_worker_count() + 1;
+  memory->physics->debug_renderer = new (push_struct(arena, JoltDebugRenderer)) JoltDebugRenderer(debug_arena, chunk_count);
+  memory->physics->debug_draw_filter = new (push_struct(arena, DebugDrawFilter)) DebugDrawFilter();
   memory->physics->debug_draw_enabled = true;
 
-  memory->physics->debug_line_resources = push_struct(arena, DebugLineResources);
+  DebugDrawResources *resources = push_struct(arena, DebugDrawResources);
+  memory->physics->debug_draw_resources = resources;
+  resources->body_ids = new (push_struct(arena, JPH::BodyIDVector)) JPH::BodyIDVector();
+  resources->primed_capacity = 256;
+  while (resources->primed_capacity < 2 * config->max_bodies)
+    resources->primed_capacity <<= 1;
+  resources->primed_shapes = push_array(arena, const JPH::Shape *, resources->primed_capacity);
   Shader shader;
   shader.create(arena, "shaders/line.vert", "shaders/line.frag", gfx);
-  memory->physics->debug_line_resources->shader = shader.program;
-
-  memory->physics->debug_line_resources->vao = gfx->create_vertex_array(arena);
-  memory->physics->debug_line_resources->vbo = gfx->create_buffer(arena, nullptr, 1024 * 1024); // 1MB buffer
-  gfx->bind_vertex_array(memory->physics->debug_line_resources->vao);
-  gfx->bind_buffer(memory->physics->debug_line_resources->vbo);
+  resources->shader = shader.program;
+  resources->instanced_shader = Shader::create_instanced(arena, gfx);
 
+  // Attribute pointers are set per frame in draw_physics, they follow the stream region
+  s32 vertex_capacity = DEBUG_LINE_INITIAL_VERTICES;
+  resources->vertex_capacity = vertex_capacity;
+  resources->stream = gfx->create_stream_buffer(arena, vertex_capacity * sizeof(JoltDebugRenderer::Vertex));
+  resources->instance_stream = gfx->create_stream_buffer(arena, DEBUG_INITIAL_INSTANCES * sizeof(JoltDebugRenderer::Instance));
+  resources->vao = gfx->create_vertex_array(arena);
+  gfx->bind_vertex_array(resources->vao);
   gfx->enable_vertex_attrib(0);
-  gfx->vertex_attrib_pointer(0, 3, sizeof(float) * 7, 0);
-
   gfx->enable_vertex_attrib(1);
-  gfx->vertex_attrib_pointer(1, 4, sizeof(float) * 7, sizeof(float) * 3);
   // --------------[ Jolt Debug Render ]-----------------
 }
\ No newline at end of file
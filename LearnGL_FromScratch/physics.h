@@ -5,7 +5,6 @@
 #include <Jolt/RegisterTypes.h>
 #include <Jolt/Core/Factory.h>
 #include <Jolt/Core/TempAllocator.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
@@ -14,95 +13,336 @@
 #include <Jolt/Physics/Collision/Shape/CylinderShape.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Body/BodyActivationListener.h>
+#include <Jolt/Physics/Body/BodyFilter.h>
 #include <Jolt/Physics/Collision/Shape/ConvexHullShape.h>
 #include <Jolt/Physics/Collision/Shape/MeshShape.h>
+#include <Jolt/Physics/Collision/Shape/OffsetCenterOfMassShape.h>
+#include <Jolt/Physics/Vehicle/MotorcycleController.h>
+#include <Jolt/Physics/Vehicle/VehicleCollisionTester.h>
+
+#include <atomic>
+#include <thread>
 
 #include "jolt_arena_allocator.h"
-#include "jolt_debug_renderer_simple.h"
+#include "jolt_job_system.h"
+#include "jolt_pool_allocator.h"
+#include "jolt_debug_renderer.h"
+#include "profiler.h"
 
 namespace Layers
 {
-  static constexpr JPH::ObjectLayer NON_MOVING = 0;
+  static constexpr JPH::ObjectLayer NON_MOVING = 0; // static world
   static constexpr JPH::ObjectLayer MOVING = 1;
-  static constexpr JPH::uint8 NUM_LAYERS = 2;
+  static constexpr JPH::ObjectLayer DEBRIS = 2;     // cheap clutter, own broadphase tree
+  static constexpr JPH::ObjectLayer SENSOR = 3;
+  static constexpr JPH::ObjectLayer VEHICLE = 4;
+  static constexpr JPH::ObjectLayer PROJECTILE = 5;
+  static constexpr JPH::uint8 NUM_LAYERS = 6;
 };
 
 namespace BroadPhaseLayers
 {
   static constexpr JPH::BroadPhaseLayer NON_MOVING(0);
   static constexpr JPH::BroadPhaseLayer MOVING(1);
-  static constexpr JPH::uint NUM_LAYERS(2);
+  static constexpr JPH::BroadPhaseLayer DEBRIS(2);
+  static constexpr JPH::BroadPhaseLayer SENSOR(3);
+  static constexpr JPH::uint NUM_LAYERS(4);
+};
+
+#define MAX_OBJECT_LAYERS 32
+
+// Object layer -> broadphase layer mapping plus collision masks, filled from a table by
+// layer_registry_init and read by the filters below without branching on the layer.
+struct LayerRegistry
+{
+  JPH::BroadPhaseLayer broadphase[MAX_OBJECT_LAYERS];
+  u32 collides[MAX_OBJECT_LAYERS];            // bit j: layer i collides with object layer j (symmetric)
+  u32 collides_broadphase[MAX_OBJECT_LAYERS]; // bit b: layer i collides with something in broadphase layer b
+  const char *names[MAX_OBJECT_LAYERS];
+  const char *broadphase_names[MAX_OBJECT_LAYERS];
+  u32 object_layer_count;
+  u32 broadphase_layer_count;
 };
 
+struct LayerDesc
+{
+  JPH::ObjectLayer layer;
+  const char *name;
+  JPH::BroadPhaseLayer broadphase;
+  u32 collides; // mask of object layers, mirrored when the registry is built
+};
+
+#define LAYER_BIT(layer) (1u << (layer))
+
+void layer_registry_init(LayerRegistry *registry, const LayerDesc *layers, u32 layer_count,
+                         const char *const *broadphase_names, u32 broadphase_layer_count);
+void layer_registry_init_default(LayerRegistry *registry);
+
 class BPLayerInterfaceImpl final : public JPH::BroadPhaseLayerInterface
 {
 public:
+  explicit BPLayerInterfaceImpl(const LayerRegistry *registry) : registry(registry) {}
+
   virtual JPH::uint GetNumBroadPhaseLayers() const override
   {
-    return BroadPhaseLayers::NUM_LAYERS;
+    return registry->broadphase_layer_count;
   }
 
   virtual JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer layer) const override
   {
-    if (layer == Layers::NON_MOVING)
-      return BroadPhaseLayers::NON_MOVING;
-    return BroadPhaseLayers::MOVING;
+    return registry->broadphase[layer];
+  }
+
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+  virtual const char *GetBroadPhaseLayerName(JPH::BroadPhaseLayer layer) const override
+  {
+    return registry->broadphase_names[(JPH::BroadPhaseLayer::Type)layer];
   }
+#endif
+
+private:
+  const LayerRegistry *registry;
 };
 
 class ObjectVsBroadPhaseLayerFilterImpl : public JPH::ObjectVsBroadPhaseLayerFilter
 {
 public:
+  explicit ObjectVsBroadPhaseLayerFilterImpl(const LayerRegistry *registry) : registry(registry) {}
+
   virtual bool ShouldCollide(JPH::ObjectLayer layer1, JPH::BroadPhaseLayer layer2) const override
   {
-    switch (layer1)
-    {
-    case Layers::NON_MOVING:
-      return layer2 == BroadPhaseLayers::MOVING;
-    case Layers::MOVING:
-      return true;
-    default:
-      return false;
-    }
+    return (registry->collides_broadphase[layer1] >> (JPH::BroadPhaseLayer::Type)layer2) & 1;
   }
+
+private:
+  const LayerRegistry *registry;
 };
 
 class ObjectLayerPairFilterImpl : public JPH::ObjectLayerPairFilter
 {
 public:
+  explicit ObjectLayerPairFilterImpl(const LayerRegistry *registry) : registry(registry) {}
+
   virtual bool ShouldCollide(JPH::ObjectLayer obj1, JPH::ObjectLayer obj2) const override
   {
-    switch (obj1)
+    return (registry->collides[obj1] >> obj2) & 1;
+  }
+
+private:
+  const LayerRegistry *registry;
+};
+
+// Sizes the PhysicsSystem, temp arena and job queue. Defaults match the old hard-coded values.
+struct PhysicsConfig
+{
+  u32 max_bodies = 1024;
+  u32 num_body_mutexes = 0; // Auto-detect
+  u32 max_body_pairs = 1024;
+  u32 max_contact_constraints = 1024;
+  u64 temp_allocator_size = MB(10);
+  u32 max_jobs = JPH::cMaxPhysicsJobs;
+  u32 max_barriers = JPH::cMaxPhysicsBarriers;
+  s32 num_threads = -1; // -1: hardware_concurrency() - 1
+  s32 worker_first_core = -1; // pin workers to consecutive cores from here, -1: no pinning
+  s32 main_thread_core = -1;  // pin the main/render thread here and keep workers off it
+  s32 worker_nice = 0;        // worker scheduling priority (Linux nice value)
+  bool pool_allocator = true; // Jolt heap allocations from size-class pools, false: malloc
+  r32 debug_draw_distance = 0.0f;     // debug draw skips bodies farther from the camera, 0: no limit
+  bool debug_draw_active_only = false; // debug draw skips sleeping and static bodies
+  bool debug_draw_parallel = true;     // split debug draw bodies across the job system
+  bool profile_report = false;         // game prints profiler zones periodically and writes trace.json on shutdown
+
+  r32 fixed_hz = 60.0f; // 0: variable step with the raw frame dt
+  u32 max_substeps = 4; // per frame, extra time is dropped to avoid spiral-of-death
+  u32 collision_steps = 1;
+  bool pipelined = false; // step on a dedicated thread, render the previous step
+};
+
+// Body user data for bodies without a slot in the PoseBuffer
+static constexpr JPH::uint64 BODY_NO_POSE = ~0ull;
+
+#define PIPELINE_FRESH 4u
+
+// Physics thread steps frame N+1 while the main thread renders N. Poses move through
+// a lock-free triple buffer: physics owns `back`, main owns `front`, `ready` holds the
+// third slot index plus PIPELINE_FRESH when it has not been picked up yet.
+struct PhysicsPipeline
+{
+  std::thread thread;
+  PoseBuffer frames[3];
+  PoseBuffer sim; // physics thread's own prev/curr, copied into back on publish
+  u32 back;
+  u32 front;
+  std::atomic<u32> ready;
+
+  std::atomic<u32> kick; // bumped by main once per frame
+  std::atomic<u32> done; // last kick the physics thread finished
+  std::atomic<r32> pending_dt;
+  std::atomic<bool> running;
+};
+
+enum class ShapeKind : u32
+{
+  BOX = 0,     // dims: half extents
+  SPHERE,      // dims: radius
+  CYLINDER,    // dims: half height, radius
+  CONVEX_HULL, // source: the Mesh whose vertices are hulled
+  CHASSIS_BOX, // dims: half extents, center of mass moved down to the bottom face
+};
+
+struct ShapeKey
+{
+  ShapeKind kind;
+  r32 dims[3];
+  const void *source;
+};
+
+inline ShapeKey shape_key(ShapeKind kind, r32 a, r32 b = 0.0f, r32 c = 0.0f, const void *source = nullptr)
+{
+  ShapeKey key = {};
+  key.kind = kind;
+  key.dims[0] = a;
+  key.dims[1] = b;
+  key.dims[2] = c;
+  key.source = source;
+  return key;
+}
+
+// One shared Shape per key, open addressing. Slots hold a reference so cached shapes
+// outlive the bodies that use them.
+struct ShapeCache
+{
+  ShapeKey *keys;
+  JPH::RefConst<JPH::Shape> *shapes;
+  u32 capacity; // power of two
+  u32 count;
+  u32 hits, misses;
+};
+
+ShapeCache *shape_cache_create(Arena *arena, u32 capacity);
+const JPH::Shape *shape_cache_find(ShapeCache *cache, const ShapeKey &key);
+void shape_cache_insert(ShapeCache *cache, Arena *arena, const ShapeKey &key, const JPH::Shape *shape);
+
+#define DEBUG_LINE_INITIAL_VERTICES (64 * 1024)
+#define DEBUG_INITIAL_INSTANCES 4096
+
+// Debug draw culling for PhysicsSystem::DrawBodies: bodies whose world bounds are outside the
+// view frustum, farther than max_distance (0: no limit) or not active (with active_only) are
+// skipped. Counters cover the last begin_frame and may be bumped from several threads.
+class DebugDrawFilter final : public JPH::BodyDrawFilter
+{
+public:
+  void begin_frame(const mat4x4 view, const mat4x4 projection, const r32 *camera_pos, r32 distance, bool active)
+  {
+    // Gribb/Hartmann: planes are row 3 +- row 0..2 of projection * view (column major)
+    mat4x4 view_projection;
+    mat4x4_mul(view_projection, projection, view);
+    for (s32 p = 0; p < 6; ++p)
     {
-    case Layers::NON_MOVING:
-      return obj2 == Layers::MOVING;
-    case Layers::MOVING:
-      return true;
-    default:
+      s32 row = p / 2;
+      r32 sign = (p & 1) ? -1.0f : 1.0f;
+      for (s32 c = 0; c < 4; ++c)
+        planes[p][c] = view_projection[c][3] + sign * view_projection[c][row];
+    }
+
+    camera = JPH::Vec3(camera_pos[0], camera_pos[1], camera_pos[2]);
+    max_distance = distance;
+    active_only = active;
+    tested = 0;
+    culled_frustum = 0;
+    culled_distance = 0;
+    culled_inactive = 0;
+  }
+
+  virtual bool ShouldDraw(const JPH::Body &inBody) const override
+  {
+    tested.fetch_add(1, std::memory_order_relaxed);
+    if (active_only && !inBody.IsActive())
+    {
+      culled_inactive.fetch_add(1, std::memory_order_relaxed);
       return false;
     }
+
+    const JPH::AABox &bounds = inBody.GetWorldSpaceBounds();
+    if (max_distance > 0.0f && bounds.GetSqDistanceTo(camera) > max_distance * max_distance)
+    {
+      culled_distance.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    // Outside when the corner farthest along a plane normal is still behind it
+    for (s32 p = 0; p < 6; ++p)
+    {
+      const r32 *plane = planes[p];
+      r32 x = plane[0] >= 0.0f ? bounds.mMax.GetX() : bounds.mMin.GetX();
+      r32 y = plane[1] >= 0.0f ? bounds.mMax.GetY() : bounds.mMin.GetY();
+      r32 z = plane[2] >= 0.0f ? bounds.mMax.GetZ() : bounds.mMin.GetZ();
+      if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f)
+      {
+        culled_frustum.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    return true;
   }
+
+  r32 planes[6][4];
+  JPH::Vec3 camera;
+  r32 max_distance;
+  bool active_only;
+
+  mutable std::atomic<u32> tested{0};
+  mutable std::atomic<u32> culled_frustum{0};
+  mutable std::atomic<u32> culled_distance{0};
+  mutable std::atomic<u32> culled_inactive{0};
 };
 
-struct DebugLineResources
+struct Shader;
+
+struct DebugDrawResources
 {
   GraphicsProgram  shader;
   GraphicsVertexArray vao;
-  GraphicsBuffer vbo;
+  GraphicsStreamBuffer stream;
+  s32 vertex_capacity; // region requested per frame, grows to last frame's count
+
+  // Triangle batches: instanced.vert with JoltDebugRenderer::Instance streamed per frame
+  Shader *instanced_shader;
+  GraphicsStreamBuffer instance_stream;
+  u32 *key_offsets; // scratch for the instance scatter, grown with the batch list
+  u32 *key_counts;
+  u32 key_capacity;
+
+  // Parallel draw: body list of the frame, and the shapes whose lazily created debug geometry
+  // exists (open addressing, only written between the jobs). Other shapes are drawn serially.
+  JPH::BodyIDVector *body_ids;
+  const JPH::Shape **primed_shapes;
+  u32 primed_count;
+  u32 primed_capacity; // power of two, fixed at init
 };
 
 typedef struct PhysicsState
 {
+  PhysicsConfig config;
   JPH::Factory *factory_instance;
+  LayerRegistry layers;
   JoltTempArenaAllocator *temp_allocator;
-  JPH::JobSystemThreadPool *job_system;
+  JobSystemWorkStealing *job_system; // shared with game tasks
   BPLayerInterfaceImpl *broad_phase_layer_interface;
   ObjectVsBroadPhaseLayerFilterImpl *object_vs_broadphase_filter;
   ObjectLayerPairFilterImpl *object_vs_object_filter;
   JPH::PhysicsSystem *physics_system;
 
-  DebugLineResources *debug_line_resources;
+  r32 accumulator; // unsimulated frame time, < 1 / fixed_hz
+  u32 *synced_poses; // pose indices written by the last sync, settled on the next one
+  u32 *synced_scratch;
+  u32 synced_count;
+  PhysicsPipeline *pipeline;
+  ShapeCache *shape_cache;
+
+  DebugDrawResources *debug_draw_resources;
   JoltDebugRenderer *debug_renderer;
+  DebugDrawFilter *debug_draw_filter;
   bool debug_draw_enabled;
 } PhysicsState;
 
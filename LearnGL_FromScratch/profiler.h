@@ -0,0 +1,238 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include "arena2.h"
+
+// Scoped CPU zones. Every thread writes its own ring of finished zones (single writer, no
+// locks); profiler_frame_end() folds the main thread's view of all rings into a per-frame
+// summary and profiler_write_chrome_trace() dumps whatever the rings still hold.
+//
+//   PROFILE_SCOPE("physics step");
+//
+// Names must be string literals (or otherwise outlive the profiler), zones are keyed by pointer.
+
+#define PROFILER_MAX_THREADS 64
+#define PROFILER_RING_EVENTS (1u << 15) // per thread, oldest zones are overwritten
+#define PROFILER_MAX_ZONES 64           // distinct names in the summary
+#define PROFILER_WINDOW_FRAMES 120      // summary is averaged over this many frames
+
+struct ProfileEvent
+{
+  const char *name;
+  u64 begin_ns;
+  u64 end_ns;
+  u32 depth;
+};
+
+struct ProfileThread
+{
+  ProfileEvent events[PROFILER_RING_EVENTS];
+  std::atomic<u64> written; // only the owning thread stores
+  u64 summarized;           // only profiler_frame_end touches this
+  const char *name;
+  u32 tid;
+  u32 depth;
+};
+
+struct ProfileZoneStats
+{
+  const char *name;
+  u64 total_ns; // over the current window
+  u64 max_ns;   // single longest zone in the window
+  u32 calls;
+};
+
+struct ProfileSummary
+{
+  ProfileZoneStats zones[PROFILER_MAX_ZONES];
+  u32 zone_count;
+  u32 frames;
+};
+
+struct Profiler
+{
+  std::atomic<bool> enabled{true};
+  std::atomic<u32> thread_count{0};
+  ProfileThread *threads[PROFILER_MAX_THREADS];
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  ProfileSummary window;  // being accumulated
+  ProfileSummary summary; // last completed window
+};
+
+inline Profiler g_profiler;
+inline thread_local ProfileThread *tls_profile_thread;
+
+inline u64 profiler_now_ns()
+{
+  using namespace std::chrono;
+  return (u64)duration_cast<nanoseconds>(steady_clock::now() - g_profiler.start).count();
+}
+
+inline ProfileThread *profiler_thread()
+{
+  if (tls_profile_thread)
+    return tls_profile_thread;
+
+  u32 index = g_profiler.thread_count.fetch_add(1);
+  if (index >= PROFILER_MAX_THREADS)
+  {
+    g_profiler.thread_count.store(PROFILER_MAX_THREADS);
+    return nullptr;
+  }
+
+  // Lives for the process, a thread's zones stay exportable after it exits
+  ProfileThread *thread = new ProfileThread();
+  thread->tid = index;
+  thread->name = "thread";
+  g_profiler.threads[index] = thread;
+  tls_profile_thread = thread;
+  return thread;
+}
+
+inline void profiler_record(const char *name, u64 begin_ns, u64 end_ns, u32 depth)
+{
+  ProfileThread *thread = profiler_thread();
+  if (!thread)
+    return;
+  u64 index = thread->written.load(std::memory_order_relaxed);
+  thread->events[index & (PROFILER_RING_EVENTS - 1)] = {name, begin_ns, end_ns, depth};
+  thread->written.store(index + 1, std::memory_order_release);
+}
+
+// Label for the calling thread in the trace
+inline void profiler_set_thread_name(const char *name)
+{
+  if (ProfileThread *thread = profiler_thread())
+    thread->name = name;
+}
+
+struct ProfileScope
+{
+  const char *name;
+  u64 begin_ns;
+  u32 depth;
+
+  explicit ProfileScope(const char *name) : name(name), begin_ns(0), depth(0)
+  {
+    if (!g_profiler.enabled.load(std::memory_order_relaxed))
+    {
+      this->name = nullptr;
+      return;
+    }
+    ProfileThread *thread = profiler_thread();
+    depth = thread ? thread->depth++ : 0;
+    begin_ns = profiler_now_ns();
+  }
+
+  ~ProfileScope()
+  {
+    if (!name)
+      return;
+    profiler_record(name, begin_ns, profiler_now_ns(), depth);
+    if (tls_profile_thread)
+      tls_profile_thread->depth--;
+  }
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+
+// Folds every zone finished since the last call into the window, call once per frame from
+// the main thread. Returns true when a window completed and g_profiler.summary was updated.
+inline bool profiler_frame_end(u32 window_frames = PROFILER_WINDOW_FRAMES)
+{
+  ProfileSummary *window = &g_profiler.window;
+  u32 thread_count = g_profiler.thread_count.load(std::memory_order_acquire);
+  for (u32 t = 0; t < thread_count; ++t)
+  {
+    ProfileThread *thread = g_profiler.threads[t];
+    if (!thread)
+      continue;
+    u64 written = thread->written.load(std::memory_order_acquire);
+    u64 begin = written - thread->summarized > PROFILER_RING_EVENTS ? written - PROFILER_RING_EVENTS : thread->summarized;
+    for (u64 i = begin; i < written; ++i)
+    {
+      const ProfileEvent *event = &thread->events[i & (PROFILER_RING_EVENTS - 1)];
+      u32 z = 0;
+      while (z < window->zone_count && window->zones[z].name != event->name)
+        z++;
+      if (z == window->zone_count)
+      {
+        if (z == PROFILER_MAX_ZONES)
+          continue;
+        window->zones[window->zone_count++] = {event->name, 0, 0, 0};
+      }
+      u64 duration = event->end_ns - event->begin_ns;
+      window->zones[z].total_ns += duration;
+      window->zones[z].calls++;
+      if (duration > window->zones[z].max_ns)
+        window->zones[z].max_ns = duration;
+    }
+    thread->summarized = written;
+  }
+
+  if (++window->frames < window_frames)
+    return false;
+  g_profiler.summary = *window;
+  *window = {};
+  return true;
+}
+
+inline void profiler_print_summary(FILE *out)
+{
+  const ProfileSummary *summary = &g_profiler.summary;
+  if (summary->frames == 0)
+    return;
+  fprintf(out, "%-24s %10s %10s %8s   (per frame, %u frames)\n", "zone", "avg ms", "max ms", "calls", summary->frames);
+  for (u32 z = 0; z < summary->zone_count; ++z)
+  {
+    const ProfileZoneStats *zone = &summary->zones[z];
+    fprintf(out, "%-24s %10.3f %10.3f %8.1f\n", zone->name, zone->total_ns / 1e6 / summary->frames,
+            zone->max_ns / 1e6, (r64)zone->calls / summary->frames);
+  }
+}
+
+// Chrome trace ("X" complete events), open with chrome://tracing or ui.perfetto.dev.
+// Reads the rings while other threads may still write, zones written meanwhile can be torn.
+inline bool profiler_write_chrome_trace(const char *path)
+{
+  FILE *file = fopen(path, "wb");
+  if (!file)
+  {
+    fprintf(stderr, "Failed to open %s\n", path);
+    return false;
+  }
+
+  fprintf(file, "{\"traceEvents\":[\n");
+  bool first = true;
+  u32 thread_count = g_profiler.thread_count.load(std::memory_order_acquire);
+  for (u32 t = 0; t < thread_count; ++t)
+  {
+    ProfileThread *thread = g_profiler.threads[t];
+    if (!thread)
+      continue;
+    fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+            first ? "" : ",\n", thread->tid, thread->name, thread->tid);
+    first = false;
+
+    u64 written = thread->written.load(std::memory_order_acquire);
+    u64 begin = written > PROFILER_RING_EVENTS ? written - PROFILER_RING_EVENTS : 0;
+    for (u64 i = begin; i < written; ++i)
+    {
+      const ProfileEvent *event = &thread->events[i & (PROFILER_RING_EVENTS - 1)];
+      fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+              event->name, thread->tid, event->begin_ns / 1e3, (event->end_ns - event->begin_ns) / 1e3);
+    }
+  }
+  fprintf(file, "\n]}\n");
+  fclose(file);
+  return true;
+}
+
+#endif // PROFILER_H
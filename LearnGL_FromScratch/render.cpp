@@ -0,0 +1,138 @@
+#include "game_api.h"
+#include "graphics_api.h"
+#include "mesh.h"
+#include "shader.h"
+#include "profiler.h"
+#include <algorithm>
+
+struct MeshSortKey
+{
+  Mesh *mesh;
+  u32 object;
+};
+
+// Groups the context's objects by Mesh and binds per-instance matrix/color buffers to
+// each mesh VAO. A mesh shared between contexts would have its instance attributes
+// rebound by the last context, so keep shared meshes within one context.
+void render_context_build_batches(Arena *arena, GraphicsAPI *gfx, RenderContext *ctx)
+{
+  ctx->batches = nullptr;
+  ctx->batch_count = 0;
+  if (!gfx || ctx->objects_count == 0)
+    return;
+
+  // Small (8 bytes per object) and only built once, so no temp scope: the batch
+  // arrays below are pushed while the keys are still in use
+  MeshSortKey *keys = push_array(arena, MeshSortKey, ctx->objects_count);
+  u32 key_count = 0;
+  for (u32 i = 0; i < ctx->objects_count; ++i)
+    if (ctx->objects[i].mesh)
+      keys[key_count++] = {ctx->objects[i].mesh, i};
+  std::sort(keys, keys + key_count, [](const MeshSortKey &a, const MeshSortKey &b)
+            { return a.mesh < b.mesh || (a.mesh == b.mesh && a.object < b.object); });
+
+  u32 batch_count = 0;
+  for (u32 i = 0; i < key_count; ++i)
+    if (i == 0 || keys[i].mesh != keys[i - 1].mesh)
+      batch_count++;
+
+  ctx->batches = push_array(arena, InstanceBatch, batch_count);
+  ctx->batch_count = batch_count;
+
+  u32 begin = 0;
+  for (u32 b = 0; b < batch_count; ++b)
+  {
+    u32 end = begin + 1;
+    while (end < key_count && keys[end].mesh == keys[begin].mesh)
+      end++;
+
+    InstanceBatch *batch = &ctx->batches[b];
+    batch->mesh = keys[begin].mesh;
+    batch->count = end - begin;
+    batch->objects = push_array(arena, u32, batch->count);
+    batch->matrices = (r32 *)arena_push(arena, 16 * sizeof(r32) * batch->count, 32, true);
+
+    // Colors are static, stage them in the matrix array before its first use
+    r32 *colors = batch->matrices;
+    for (u32 k = 0; k < batch->count; ++k)
+    {
+      u32 object = keys[begin + k].object;
+      batch->objects[k] = object;
+      colors[3 * k + 0] = ctx->objects[object].color[0];
+      colors[3 * k + 1] = ctx->objects[object].color[1];
+      colors[3 * k + 2] = ctx->objects[object].color[2];
+    }
+    batch->color_vbo = gfx->create_buffer(arena, colors, 3 * sizeof(r32) * batch->count);
+    batch->matrix_vbo = gfx->create_dynamic_buffer(arena, 16 * sizeof(r32) * batch->count);
+
+    gfx->bind_vertex_array(batch->mesh->vao);
+    gfx->bind_buffer(batch->matrix_vbo);
+    for (s32 c = 0; c < 4; ++c)
+    {
+      gfx->enable_vertex_attrib(3 + c);
+      gfx->vertex_attrib_pointer(3 + c, 4, 16 * sizeof(r32), c * 4 * sizeof(r32));
+      gfx->vertex_attrib_divisor(3 + c, 1);
+    }
+    gfx->bind_buffer(batch->color_vbo);
+    gfx->enable_vertex_attrib(7);
+    gfx->vertex_attrib_pointer(7, 3, 3 * sizeof(r32), 0);
+    gfx->vertex_attrib_divisor(7, 1);
+    gfx->bind_vertex_array(nullptr);
+
+    begin = end;
+  }
+}
+
+// models is indexed by pose (ctx->pose_base + object). Only instances whose pose lies in
+// [dirty_begin, dirty_end) are uploaded again, the rest of the instance buffer is still current.
+void render_context_draw(GraphicsAPI *gfx, RenderContext *ctx, const mat4x4 *models, u32 dirty_begin, u32 dirty_end,
+                         const r32 *view, const r32 *projection, const r32 *light_pos, const r32 *view_pos)
+{
+  PROFILE_SCOPE("render_context_draw");
+  Shader *shader = ctx->batches ? ctx->instanced_shader : ctx->shader;
+  shader->use(gfx);
+
+  shader->set_mat4(gfx, "view", view);
+  shader->set_mat4(gfx, "projection", projection);
+  shader->set_vec3(gfx, "light_pos", (r32 *)light_pos);
+  shader->set_vec3(gfx, "view_pos", (r32 *)view_pos);
+
+  if (ctx->batches)
+  {
+    for (u32 b = 0; b < ctx->batch_count; ++b)
+    {
+      InstanceBatch *batch = &ctx->batches[b];
+
+      // Objects are sorted within a batch, so the dirty poses are one run of instances
+      u32 first = 0;
+      u32 last = batch->count;
+      if (batch->uploaded)
+      {
+        u32 object_begin = dirty_begin > ctx->pose_base ? dirty_begin - ctx->pose_base : 0;
+        u32 object_end = dirty_end > ctx->pose_base ? dirty_end - ctx->pose_base : 0;
+        first = (u32)(std::lower_bound(batch->objects, batch->objects + batch->count, object_begin) - batch->objects);
+        last = (u32)(std::lower_bound(batch->objects, batch->objects + batch->count, object_end) - batch->objects);
+      }
+      batch->uploaded = true;
+
+      if (last > first)
+      {
+        for (u32 k = first; k < last; ++k)
+          memcpy(batch->matrices + 16 * k, models[ctx->pose_base + batch->objects[k]], sizeof(mat4x4));
+        gfx->update_buffer_range(batch->matrix_vbo, 16 * sizeof(r32) * first, batch->matrices + 16 * first,
+                                 16 * sizeof(r32) * (last - first));
+      }
+      batch->mesh->draw_instanced(gfx, (s32)batch->count);
+    }
+    return;
+  }
+
+  UniformHandle model_uniform = shader->uniform(gfx, "model");
+  UniformHandle tint_uniform = shader->uniform(gfx, "tint");
+  for (u32 j = 0; j < ctx->objects_count; ++j)
+  {
+    shader->set_mat4(gfx, model_uniform, (const r32 *)models[ctx->pose_base + j]);
+    shader->set_vec3(gfx, tint_uniform, ctx->objects[j].color);
+    ctx->objects[j].mesh->draw(gfx);
+  }
+}
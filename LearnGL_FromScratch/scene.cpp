@@ -0,0 +1,320 @@
+#include "scene.h"
+#include "physics.h"
+#include "game_api.h"
+#include "mesh.h"
+#include <math.h>
+#include <stdio.h>
+#include <assert.h>
+
+void render_context_alloc(Arena *arena, RenderContext *ctx, u32 objects_count)
+{
+  ctx->objects_count = objects_count;
+  ctx->objects = push_array(arena, Object, objects_count);
+}
+
+static Mesh *scene_mesh(GameMemory *memory, GeometryKey key)
+{
+  if (!memory->geometry_cache)
+    memory->geometry_cache = geometry_cache_create(memory->arena, 64);
+  return geometry_cache_get(memory->geometry_cache, memory->arena, memory->gfx, key);
+}
+
+// Identical bodies share one Shape, built on the first miss
+static JPH::RefConst<JPH::Shape> scene_shape(GameMemory *memory, ShapeKey key)
+{
+  ShapeCache *cache = memory->physics->shape_cache;
+  if (const JPH::Shape *cached = shape_cache_find(cache, key))
+    return cached;
+
+  JPH::ShapeSettings::ShapeResult result;
+  switch (key.kind)
+  {
+  case ShapeKind::BOX:
+    result = JPH::BoxShapeSettings(JPH::Vec3(key.dims[0], key.dims[1], key.dims[2])).Create();
+    break;
+  case ShapeKind::SPHERE:
+    result = JPH::SphereShapeSettings(key.dims[0]).Create();
+    break;
+  case ShapeKind::CYLINDER:
+    result = JPH::CylinderShapeSettings(key.dims[0], key.dims[1]).Create();
+    break;
+  case ShapeKind::CONVEX_HULL:
+  {
+    JPH::RefConst<JPH::Shape> hull = ((const Mesh *)key.source)->load_convex_hull(HULL_CACHE_DIR);
+    shape_cache_insert(cache, memory->arena, key, hull);
+    return hull;
+  }
+  case ShapeKind::CHASSIS_BOX:
+    result = JPH::OffsetCenterOfMassShapeSettings(
+                 JPH::Vec3(0, -key.dims[1], 0), new JPH::BoxShape(JPH::Vec3(key.dims[0], key.dims[1], key.dims[2])))
+                 .Create();
+    break;
+  }
+
+  if (result.HasError())
+  {
+    fprintf(stderr, "Shape creation failed: %s\n", result.GetError().c_str());
+    return nullptr;
+  }
+  shape_cache_insert(cache, memory->arena, key, result.Get());
+  return result.Get();
+}
+
+// Fills in the object's mesh and color and returns its body settings, the caller adds the body
+static JPH::BodyCreationSettings object_body_settings(GameMemory *memory, Object *object, ObjectType type, CreateObjectParams params)
+{
+  JPH::Vec3 jolt_pos(params.loc[0], params.loc[1], params.loc[2]);
+  JPH::EMotionType motion = (type == ObjectType::GROUND) ? JPH::EMotionType::Static : JPH::EMotionType::Dynamic;
+  JPH::ObjectLayer layer = (type == ObjectType::GROUND) ? Layers::NON_MOVING : Layers::MOVING;
+
+  JPH::RefConst<JPH::Shape> shape;
+
+  switch (type)
+  {
+  case ObjectType::GROUND:
+  {
+    object->mesh = scene_mesh(memory, geometry_key(MeshPrimitive::GROUND, params.size[0]));
+    shape = scene_shape(memory, shape_key(ShapeKind::BOX, params.size[0], 0.1f, params.size[0]));
+    jolt_pos = JPH::Vec3(0, -0.1f, 0);
+    break;
+  }
+  case ObjectType::BOX:
+  {
+    object->mesh = scene_mesh(memory, geometry_key(MeshPrimitive::BOX, params.size[0], params.size[1], params.size[2]));
+    shape = scene_shape(memory, shape_key(ShapeKind::BOX, params.size[0], params.size[1], params.size[2]));
+    break;
+  }
+  case ObjectType::SPHERE:
+  {
+    object->mesh = scene_mesh(memory, geometry_key(MeshPrimitive::SPHERE, params.size[0], 0.0f, 0.0f, 36, 18));
+    shape = scene_shape(memory, shape_key(ShapeKind::SPHERE, params.size[0]));
+    break;
+  }
+  case ObjectType::CYLINDER:
+  {
+    object->mesh = scene_mesh(memory, geometry_key(MeshPrimitive::CYLINDER, params.size[0], params.size[1], 0.0f, 36));
+    shape = scene_shape(memory, shape_key(ShapeKind::CYLINDER, params.size[1] * 0.5f, params.size[0]));
+    break;
+  }
+  case ObjectType::CONE:
+  {
+    object->mesh = scene_mesh(memory, geometry_key(MeshPrimitive::CONE, params.size[0], params.size[1], 0.0f, 36));
+    // The mesh is shared through the geometry cache, so it identifies the hull
+    shape = scene_shape(memory, shape_key(ShapeKind::CONVEX_HULL, 0.0f, 0.0f, 0.0f, object->mesh));
+    break;
+  }
+  case ObjectType::MOTORCYCLE:
+    assert(!"use create_motorcycle");
+    break;
+  }
+
+  JPH::BodyCreationSettings body_settings(shape, jolt_pos, JPH::Quat::sIdentity(), motion, layer);
+  body_settings.mUserData = BODY_NO_POSE;
+  object->type = type;
+  vec3_dup(object->color, params.color);
+  return body_settings;
+}
+
+void create_object(GameMemory *memory, JPH::BodyInterface &body_interface, Object *object, ObjectType type, CreateObjectParams params)
+{
+  JPH::BodyCreationSettings body_settings = object_body_settings(memory, object, type, params);
+  JPH::EActivation activation = (type == ObjectType::GROUND) ? JPH::EActivation::DontActivate : JPH::EActivation::Activate;
+  object->body_id = push_struct(memory->arena, JPH::BodyID);
+  *object->body_id = body_interface.CreateAndAddBody(body_settings, activation);
+}
+
+// Same chassis/wheel setup as MotorcycleDemo, throttle held open so it never sleeps
+void create_motorcycle(GameMemory *memory, JPH::BodyInterface &body_interface, Object *object, CreateObjectParams params)
+{
+  Arena *arena = memory->arena;
+  JPH::PhysicsSystem *physics_system = memory->physics->physics_system;
+
+  const r32 hw = 0.2f, hh = 0.3f, hl = 0.4f;
+
+  object->mesh = scene_mesh(memory, geometry_key(MeshPrimitive::BOX, hw, hh, hl));
+  object->body_id = push_struct(arena, JPH::BodyID);
+  *object->body_id = JPH::BodyID();
+  object->type = ObjectType::MOTORCYCLE;
+  vec3_dup(object->color, params.color);
+
+  JPH::RefConst<JPH::Shape> shape = scene_shape(memory, shape_key(ShapeKind::CHASSIS_BOX, hw, hh, hl));
+
+  JPH::BodyCreationSettings body_settings(shape, JPH::Vec3(params.loc[0], params.loc[1], params.loc[2]), JPH::Quat::sIdentity(),
+                                          JPH::EMotionType::Dynamic, Layers::MOVING);
+  body_settings.mOverrideMassProperties = JPH::EOverrideMassProperties::CalculateInertia;
+  body_settings.mMassPropertiesOverride.mMass = 240.0f;
+  body_settings.mUserData = BODY_NO_POSE;
+
+  JPH::Body *body = body_interface.CreateBody(body_settings);
+  if (!body)
+    return; // body_id stays invalid, caller counts it as not spawned
+  *object->body_id = body->GetID();
+  body_interface.AddBody(body->GetID(), JPH::EActivation::Activate);
+
+  JPH::VehicleConstraintSettings vehicle;
+
+  JPH::WheelSettingsWV *front = new JPH::WheelSettingsWV;
+  front->mPosition = JPH::Vec3(0.0f, -0.9f * hh, 0.75f);
+  front->mMaxSteerAngle = JPH::DegreesToRadians(30);
+  front->mRadius = 0.31f;
+  front->mWidth = 0.05f;
+  front->mSuspensionMinLength = 0.3f;
+  front->mSuspensionMaxLength = 0.5f;
+  front->mSuspensionSpring.mFrequency = 1.5f;
+  front->mMaxBrakeTorque = 500.0f;
+  const r32 caster_angle = JPH::DegreesToRadians(30);
+  front->mSuspensionDirection = JPH::Vec3(0, -1, JPH::Tan(caster_angle)).Normalized();
+  front->mSteeringAxis = -front->mSuspensionDirection;
+
+  JPH::WheelSettingsWV *back = new JPH::WheelSettingsWV;
+  back->mPosition = JPH::Vec3(0.0f, -0.9f * hh, -0.75f);
+  back->mMaxSteerAngle = 0.0f;
+  back->mRadius = 0.31f;
+  back->mWidth = 0.05f;
+  back->mSuspensionMinLength = 0.3f;
+  back->mSuspensionMaxLength = 0.5f;
+  back->mSuspensionSpring.mFrequency = 2.0f;
+  back->mMaxBrakeTorque = 250.0f;
+
+  vehicle.mWheels = {front, back};
+
+  JPH::MotorcycleControllerSettings *controller = new JPH::MotorcycleControllerSettings;
+  controller->mEngine.mMaxTorque = 150.0f;
+  controller->mEngine.mMinRPM = 1000.0f;
+  controller->mEngine.mMaxRPM = 10000.0f;
+  controller->mTransmission.mShiftDownRPM = 2000.0f;
+  controller->mTransmission.mShiftUpRPM = 8000.0f;
+  controller->mTransmission.mGearRatios = {2.27f, 1.63f, 1.3f, 1.09f, 0.96f, 0.88f};
+  controller->mTransmission.mClutchStrength = 2.0f;
+  controller->mDifferentials.resize(1);
+  controller->mDifferentials[0].mLeftWheel = -1;
+  controller->mDifferentials[0].mRightWheel = 1;
+  controller->mDifferentials[0].mDifferentialRatio = 1.93f * 40.0f / 16.0f;
+  vehicle.mController = controller;
+
+  JPH::VehicleConstraint *vehicle_constraint = new JPH::VehicleConstraint(*body, vehicle);
+  vehicle_constraint->SetVehicleCollisionTester(new JPH::VehicleCollisionTesterRay(Layers::MOVING));
+  physics_system->AddConstraint(vehicle_constraint);
+  physics_system->AddStepListener(vehicle_constraint);
+
+  JPH::MotorcycleController *mc = static_cast<JPH::MotorcycleController *>(vehicle_constraint->GetController());
+  mc->EnableLeanController(true);
+  mc->SetDriverInput(1.0f, 0.0f, 0.0f, false);
+}
+
+static r32 scene_rand01(u32 *state)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return (r32)(*state >> 8) / (r32)(1u << 24);
+}
+
+// Square-ish grid side for n cells
+static u32 scene_grid_side(u32 n)
+{
+  u32 side = (u32)ceilf(sqrtf((r32)n));
+  return side ? side : 1;
+}
+
+void spawn_scene(GameMemory *memory, RenderContext *ctx, SceneParams params)
+{
+  PROFILE_SCOPE("spawn_scene");
+  Arena *arena = memory->arena;
+  JPH::BodyInterface &body_interface = memory->physics->physics_system->GetBodyInterface();
+
+  render_context_alloc(arena, ctx, scene_object_count(params));
+
+  u32 o_idx = 0;
+  u32 rng = params.seed;
+  create_object(memory, body_interface, &ctx->objects[o_idx++], ObjectType::GROUND, {{200.0f}, {}, {.2, .3, .2}});
+
+  // Dynamic objects are collected here and added in one physics_spawn_bodies call
+  u32 bulk_begin = o_idx;
+  JPH::Array<JPH::BodyCreationSettings> bulk;
+  bulk.reserve(params.count);
+  auto spawn = [&](ObjectType type, CreateObjectParams object_params)
+  {
+    bulk.push_back(object_body_settings(memory, &ctx->objects[o_idx++], type, object_params));
+  };
+
+  switch (params.type)
+  {
+  case SceneType::BOX_STACK:
+  {
+    const u32 height = 10;
+    u32 columns = (params.count + height - 1) / height;
+    u32 side = scene_grid_side(columns);
+    for (u32 i = 0; i < params.count; ++i)
+    {
+      u32 column = i / height;
+      u32 level = i % height;
+      r32 x = ((r32)(column % side) - side * 0.5f) * 2.0f;
+      r32 z = ((r32)(column / side) - side * 0.5f) * 2.0f;
+      spawn(ObjectType::BOX, {{0.5f, 0.5f, 0.5f}, {x, 0.5f + level * 1.0f, z}, {.8, .2, .2}});
+    }
+    break;
+  }
+  case SceneType::PILE:
+  {
+    const u32 layer_side = 20;
+    for (u32 i = 0; i < params.count; ++i)
+    {
+      u32 layer = i / (layer_side * layer_side);
+      u32 cell = i % (layer_side * layer_side);
+      r32 x = ((r32)(cell % layer_side) - layer_side * 0.5f) * 0.6f + (scene_rand01(&rng) - 0.5f) * 0.1f;
+      r32 z = ((r32)(cell / layer_side) - layer_side * 0.5f) * 0.6f + (scene_rand01(&rng) - 0.5f) * 0.1f;
+      r32 y = 2.0f + layer * 0.6f;
+      spawn(ObjectType::BOX, {{0.25f, 0.25f, 0.25f}, {x, y, z}, {.8, .4, .2}});
+    }
+    break;
+  }
+  case SceneType::MIXED_HULLS:
+  {
+    const u32 layer_side = 10;
+    for (u32 i = 0; i < params.count; ++i)
+    {
+      u32 layer = i / (layer_side * layer_side);
+      u32 cell = i % (layer_side * layer_side);
+      r32 x = ((r32)(cell % layer_side) - layer_side * 0.5f) * 1.5f + (scene_rand01(&rng) - 0.5f) * 0.2f;
+      r32 z = ((r32)(cell / layer_side) - layer_side * 0.5f) * 1.5f + (scene_rand01(&rng) - 0.5f) * 0.2f;
+      r32 y = 2.0f + layer * 1.5f;
+
+      switch (i % 3)
+      {
+      case 0:
+        spawn(ObjectType::SPHERE, {{0.5f}, {x, y, z}, {.2, .2, .8}});
+        break;
+      case 1:
+        spawn(ObjectType::CYLINDER, {{0.4f, 1.0f}, {x, y, z}, {.8, .8, .2}});
+        break;
+      case 2:
+        spawn(ObjectType::CONE, {{0.5f, 1.0f}, {x, y, z}, {.8, .4, .2}});
+        break;
+      }
+    }
+    break;
+  }
+  case SceneType::MOTORCYCLES:
+  {
+    u32 side = scene_grid_side(params.count);
+    for (u32 i = 0; i < params.count; ++i)
+    {
+      r32 x = ((r32)(i % side) - side * 0.5f) * 3.0f;
+      r32 z = ((r32)(i / side) - side * 0.5f) * 3.0f;
+      create_motorcycle(memory, body_interface, &ctx->objects[o_idx++], {{}, {x, 2.0f, z}, {.8, .2, .2}});
+    }
+    break;
+  }
+  }
+
+  if (!bulk.empty())
+  {
+    u32 bulk_count = (u32)bulk.size();
+    JPH::BodyID *ids = push_array_no_zero(arena, JPH::BodyID, bulk_count);
+    for (u32 i = 0; i < bulk_count; ++i)
+      ctx->objects[bulk_begin + i].body_id = &ids[i];
+    physics_spawn_bodies(memory->physics, bulk.data(), bulk_count, ids, JPH::EActivation::Activate);
+  }
+
+  assert(o_idx == ctx->objects_count && "objects_count MISMATCH");
+  memory->physics->physics_system->OptimizeBroadPhase();
+}
@@ -0,0 +1,29 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "defines.h"
+
+enum class SceneType
+{
+  BOX_STACK = 0, // columns of boxes, 10 high
+  PILE,          // loose boxes dropped into one heap
+  MIXED_HULLS,   // spheres, cylinders and convex hull cones
+  MOTORCYCLES,   // N motorcycles with throttle held open
+};
+
+struct SceneParams
+{
+  SceneType type = SceneType::BOX_STACK;
+  u32 count = 100;
+  u32 seed = 1;
+};
+
+static const char *scene_type_names[] = {"stack", "pile", "mixed", "motorcycles"};
+
+// Ground + one object per requested body
+inline u32 scene_object_count(const SceneParams &params)
+{
+  return params.count + 1;
+}
+
+#endif // SCENE_H
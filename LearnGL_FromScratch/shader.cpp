@@ -89,7 +89,7 @@ void Shader::set_vec4(GraphicsAPI *gfx, const char *name, r32 *data) const
 void Shader::set_vec4(GraphicsAPI *gfx, const char *name, r32 x, r32 y, r32 z, r32 w) const
 {
   vec4 data{x, y, z, w};
-  gfx->set_vec4(gfx, name, data);
+  gfx->set_vec4(program, name, data);
 }
 
 void Shader::set_mat4(GraphicsAPI *gfx, const char *name, const r32 *mat) const
@@ -97,6 +97,38 @@ void Shader::set_mat4(GraphicsAPI *gfx, const char *name, const r32 *mat) const
   gfx->set_mat4(program, name, mat);
 }
 
+UniformHandle Shader::uniform(GraphicsAPI *gfx, const char *name) const
+{
+  if (!is_loaded)
+    return UNIFORM_NONE;
+  return gfx->find_uniform(program, name);
+}
+
+void Shader::set_int(GraphicsAPI *gfx, UniformHandle handle, s32 value) const
+{
+  gfx->set_uniform_int(program, handle, value);
+}
+
+void Shader::set_float(GraphicsAPI *gfx, UniformHandle handle, r32 value) const
+{
+  gfx->set_uniform_float(program, handle, value);
+}
+
+void Shader::set_vec3(GraphicsAPI *gfx, UniformHandle handle, const r32 *data) const
+{
+  gfx->set_uniform_vec3(program, handle, data);
+}
+
+void Shader::set_vec4(GraphicsAPI *gfx, UniformHandle handle, const r32 *data) const
+{
+  gfx->set_uniform_vec4(program, handle, data);
+}
+
+void Shader::set_mat4(GraphicsAPI *gfx, UniformHandle handle, const r32 *mat) const
+{
+  gfx->set_uniform_mat4(program, handle, mat);
+}
+
 Shader *Shader::create_basic(Arena *arena, GraphicsAPI *gfx)
 {
   Shader *shader = push_struct(arena, Shader);
@@ -110,3 +142,11 @@ Shader *Shader::create_lit(Arena *arena, GraphicsAPI *gfx)
   shader->create(arena, "shaders/lit.vert", "shaders/lit.frag", gfx);
   return shader;
 }
+
+// basic.frag with model matrix and color per instance
+Shader *Shader::create_instanced(Arena *arena, GraphicsAPI *gfx)
+{
+  Shader *shader = push_struct(arena, Shader);
+  shader->create(arena, "shaders/instanced.vert", "shaders/basic.frag", gfx);
+  return shader;
+}
@@ -27,9 +27,18 @@ struct Shader
   void set_vec4(GraphicsAPI *gfx, const char *name, r32 *data) const;
   void set_mat4(GraphicsAPI *gfx, const char *name, const r32 *mat) const;
 
+  // Resolve once, then set per draw without a name lookup
+  UniformHandle uniform(GraphicsAPI *gfx, const char *name) const;
+  void set_int(GraphicsAPI *gfx, UniformHandle handle, s32 value) const;
+  void set_float(GraphicsAPI *gfx, UniformHandle handle, r32 value) const;
+  void set_vec3(GraphicsAPI *gfx, UniformHandle handle, const r32 *data) const;
+  void set_vec4(GraphicsAPI *gfx, UniformHandle handle, const r32 *data) const;
+  void set_mat4(GraphicsAPI *gfx, UniformHandle handle, const r32 *mat) const;
+
   // Static helper to load common shaders
   static Shader *create_basic(Arena *arena, GraphicsAPI *gfx);
   static Shader *create_lit(Arena *arena, GraphicsAPI *gfx);
+  static Shader *create_instanced(Arena *arena, GraphicsAPI *gfx);
 };
 
 #endif // SHADER_H
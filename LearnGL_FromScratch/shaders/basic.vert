@@ -6,6 +6,7 @@ layout(location = 2) in vec3 color;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform vec3 tint; // per-object color, meshes are shared and white
 
 out vec3 frag_normal;
 out vec3 frag_color;
@@ -14,6 +15,6 @@ out vec3 frag_pos;
 void main() {
     frag_pos = vec3(model * vec4(position, 1.0));
     frag_normal = mat3(transpose(inverse(model))) * normal;
-    frag_color = color;
+    frag_color = color * tint;
     gl_Position = projection * view * vec4(frag_pos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 410 core
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec3 color;
+layout(location = 3) in mat4 instance_model; // locations 3-6
+layout(location = 7) in vec3 instance_color;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 frag_normal;
+out vec3 frag_color;
+out vec3 frag_pos;
+
+void main() {
+    frag_pos = vec3(instance_model * vec4(position, 1.0));
+    // Body transforms are rigid, the rotation part is already the normal matrix
+    frag_normal = mat3(instance_model) * normal;
+    frag_color = color * instance_color;
+    gl_Position = projection * view * vec4(frag_pos, 1.0);
+}
\ No newline at end of file
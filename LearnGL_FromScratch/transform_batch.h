@@ -0,0 +1,218 @@
+#ifndef TRANSFORM_BATCH_H
+#define TRANSFORM_BATCH_H
+
+// Batched pose -> matrix conversion. Reads SoA prev/curr poses, blends them by alpha
+// (lerp position, nlerp rotation) and writes column-major mat4s, optionally with the
+// normal matrix as 3 padded vec4 columns (std140 mat3). For rigid bodies the normal
+// matrix is just the rotation, no inverse needed.
+//
+// Vector path picked at compile time: AVX2 (8 wide), SSE2 / NEON (4 wide), else scalar.
+
+#include <math.h>
+#include "game_api.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define POSE_BATCH_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define POSE_BATCH_WIDTH 4
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define POSE_BATCH_WIDTH 4
+#else
+#define POSE_BATCH_WIDTH 1
+#endif
+
+static inline void pose_batch_scalar(const TransformSoA *a, const TransformSoA *b, r32 t, u32 i, r32 *model, r32 *normal)
+{
+  r32 dot = a->qx[i] * b->qx[i] + a->qy[i] * b->qy[i] + a->qz[i] * b->qz[i] + a->qw[i] * b->qw[i];
+  r32 tb = dot < 0.0f ? -t : t;
+  r32 ta = 1.0f - t;
+
+  r32 x = a->qx[i] * ta + b->qx[i] * tb;
+  r32 y = a->qy[i] * ta + b->qy[i] * tb;
+  r32 z = a->qz[i] * ta + b->qz[i] * tb;
+  r32 w = a->qw[i] * ta + b->qw[i] * tb;
+  r32 inv = 1.0f / sqrtf(x * x + y * y + z * z + w * w);
+  x *= inv;
+  y *= inv;
+  z *= inv;
+  w *= inv;
+
+  r32 xx = x * x, yy = y * y, zz = z * z, ww = w * w;
+  r32 xy = x * y, xz = x * z, yz = y * z;
+  r32 wx = w * x, wy = w * y, wz = w * z;
+
+  r32 m[16] = {
+      ww + xx - yy - zz, 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f,
+      2.0f * (xy - wz), ww - xx + yy - zz, 2.0f * (yz + wx), 0.0f,
+      2.0f * (xz + wy), 2.0f * (yz - wx), ww - xx - yy + zz, 0.0f,
+      a->px[i] + (b->px[i] - a->px[i]) * t,
+      a->py[i] + (b->py[i] - a->py[i]) * t,
+      a->pz[i] + (b->pz[i] - a->pz[i]) * t,
+      1.0f,
+  };
+
+  for (int k = 0; k < 16; ++k)
+    model[k] = m[k];
+  if (normal)
+    for (int k = 0; k < 12; ++k)
+      normal[k] = m[k];
+}
+
+#if POSE_BATCH_WIDTH == 8
+
+typedef __m256 pbv;
+static inline pbv pbv_set1(r32 v) { return _mm256_set1_ps(v); }
+static inline pbv pbv_load(const r32 *p) { return _mm256_loadu_ps(p); }
+static inline pbv pbv_add(pbv a, pbv b) { return _mm256_add_ps(a, b); }
+static inline pbv pbv_sub(pbv a, pbv b) { return _mm256_sub_ps(a, b); }
+static inline pbv pbv_mul(pbv a, pbv b) { return _mm256_mul_ps(a, b); }
+static inline pbv pbv_div(pbv a, pbv b) { return _mm256_div_ps(a, b); }
+static inline pbv pbv_sqrt(pbv a) { return _mm256_sqrt_ps(a); }
+// v with the sign of s flipped in where s is negative
+static inline pbv pbv_xorsign(pbv v, pbv s) { return _mm256_xor_ps(v, _mm256_and_ps(s, _mm256_set1_ps(-0.0f))); }
+
+// Lane k of r0..r3 -> base[stride * k + offset + 0..3]
+static inline void pbv_store4(r32 *base, u32 stride, u32 offset, pbv r0, pbv r1, pbv r2, pbv r3)
+{
+  // In-lane 4x4 transpose: low half holds lanes 0-3, high half lanes 4-7
+  __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+  __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+  __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+  __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+  __m256 c[4] = {
+      _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+      _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+      _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+      _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)),
+  };
+  for (u32 k = 0; k < 4; ++k)
+  {
+    _mm_storeu_ps(base + stride * k + offset, _mm256_castps256_ps128(c[k]));
+    _mm_storeu_ps(base + stride * (k + 4) + offset, _mm256_extractf128_ps(c[k], 1));
+  }
+}
+
+#elif POSE_BATCH_WIDTH == 4 && !defined(__ARM_NEON)
+
+typedef __m128 pbv;
+static inline pbv pbv_set1(r32 v) { return _mm_set1_ps(v); }
+static inline pbv pbv_load(const r32 *p) { return _mm_loadu_ps(p); }
+static inline pbv pbv_add(pbv a, pbv b) { return _mm_add_ps(a, b); }
+static inline pbv pbv_sub(pbv a, pbv b) { return _mm_sub_ps(a, b); }
+static inline pbv pbv_mul(pbv a, pbv b) { return _mm_mul_ps(a, b); }
+static inline pbv pbv_div(pbv a, pbv b) { return _mm_div_ps(a, b); }
+static inline pbv pbv_sqrt(pbv a) { return _mm_sqrt_ps(a); }
+static inline pbv pbv_xorsign(pbv v, pbv s) { return _mm_xor_ps(v, _mm_and_ps(s, _mm_set1_ps(-0.0f))); }
+
+static inline void pbv_store4(r32 *base, u32 stride, u32 offset, pbv r0, pbv r1, pbv r2, pbv r3)
+{
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  _mm_storeu_ps(base + stride * 0 + offset, r0);
+  _mm_storeu_ps(base + stride * 1 + offset, r1);
+  _mm_storeu_ps(base + stride * 2 + offset, r2);
+  _mm_storeu_ps(base + stride * 3 + offset, r3);
+}
+
+#elif POSE_BATCH_WIDTH == 4
+
+typedef float32x4_t pbv;
+static inline pbv pbv_set1(r32 v) { return vdupq_n_f32(v); }
+static inline pbv pbv_load(const r32 *p) { return vld1q_f32(p); }
+static inline pbv pbv_add(pbv a, pbv b) { return vaddq_f32(a, b); }
+static inline pbv pbv_sub(pbv a, pbv b) { return vsubq_f32(a, b); }
+static inline pbv pbv_mul(pbv a, pbv b) { return vmulq_f32(a, b); }
+static inline pbv pbv_div(pbv a, pbv b) { return vdivq_f32(a, b); }
+static inline pbv pbv_sqrt(pbv a) { return vsqrtq_f32(a); }
+static inline pbv pbv_xorsign(pbv v, pbv s)
+{
+  uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(s), vdupq_n_u32(0x80000000u));
+  return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(v), sign));
+}
+
+static inline void pbv_store4(r32 *base, u32 stride, u32 offset, pbv r0, pbv r1, pbv r2, pbv r3)
+{
+  float32x4x2_t t01 = vtrnq_f32(r0, r1);
+  float32x4x2_t t23 = vtrnq_f32(r2, r3);
+  vst1q_f32(base + stride * 0 + offset, vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])));
+  vst1q_f32(base + stride * 1 + offset, vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1])));
+  vst1q_f32(base + stride * 2 + offset, vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])));
+  vst1q_f32(base + stride * 3 + offset, vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])));
+}
+
+#endif
+
+// models: 16 floats per pose, normals: 12 floats per pose or nullptr. Both indexed by pose.
+static inline void pose_batch_to_mat4(const TransformSoA *a, const TransformSoA *b, r32 alpha,
+                                      u32 begin, u32 end, r32 *models, r32 *normals)
+{
+  u32 i = begin;
+
+#if POSE_BATCH_WIDTH > 1
+  const pbv t = pbv_set1(alpha);
+  const pbv ta = pbv_set1(1.0f - alpha);
+  const pbv one = pbv_set1(1.0f);
+  const pbv two = pbv_set1(2.0f);
+  const pbv zero = pbv_set1(0.0f);
+
+  for (; i + POSE_BATCH_WIDTH <= end; i += POSE_BATCH_WIDTH)
+  {
+    pbv ax = pbv_load(a->qx + i), ay = pbv_load(a->qy + i), az = pbv_load(a->qz + i), aw = pbv_load(a->qw + i);
+    pbv bx = pbv_load(b->qx + i), by = pbv_load(b->qy + i), bz = pbv_load(b->qz + i), bw = pbv_load(b->qw + i);
+
+    pbv dot = pbv_add(pbv_add(pbv_mul(ax, bx), pbv_mul(ay, by)), pbv_add(pbv_mul(az, bz), pbv_mul(aw, bw)));
+    pbv tb = pbv_xorsign(t, dot);
+
+    pbv x = pbv_add(pbv_mul(ax, ta), pbv_mul(bx, tb));
+    pbv y = pbv_add(pbv_mul(ay, ta), pbv_mul(by, tb));
+    pbv z = pbv_add(pbv_mul(az, ta), pbv_mul(bz, tb));
+    pbv w = pbv_add(pbv_mul(aw, ta), pbv_mul(bw, tb));
+    pbv len2 = pbv_add(pbv_add(pbv_mul(x, x), pbv_mul(y, y)), pbv_add(pbv_mul(z, z), pbv_mul(w, w)));
+    pbv inv = pbv_div(one, pbv_sqrt(len2));
+    x = pbv_mul(x, inv);
+    y = pbv_mul(y, inv);
+    z = pbv_mul(z, inv);
+    w = pbv_mul(w, inv);
+
+    pbv xx = pbv_mul(x, x), yy = pbv_mul(y, y), zz = pbv_mul(z, z), ww = pbv_mul(w, w);
+    pbv xy = pbv_mul(x, y), xz = pbv_mul(x, z), yz = pbv_mul(y, z);
+    pbv wx = pbv_mul(w, x), wy = pbv_mul(w, y), wz = pbv_mul(w, z);
+
+    pbv m00 = pbv_sub(pbv_sub(pbv_add(ww, xx), yy), zz);
+    pbv m01 = pbv_mul(two, pbv_add(xy, wz));
+    pbv m02 = pbv_mul(two, pbv_sub(xz, wy));
+    pbv m10 = pbv_mul(two, pbv_sub(xy, wz));
+    pbv m11 = pbv_sub(pbv_add(pbv_sub(ww, xx), yy), zz);
+    pbv m12 = pbv_mul(two, pbv_add(yz, wx));
+    pbv m20 = pbv_mul(two, pbv_add(xz, wy));
+    pbv m21 = pbv_mul(two, pbv_sub(yz, wx));
+    pbv m22 = pbv_add(pbv_sub(pbv_sub(ww, xx), yy), zz);
+
+    pbv apx = pbv_load(a->px + i), apy = pbv_load(a->py + i), apz = pbv_load(a->pz + i);
+    pbv px = pbv_add(apx, pbv_mul(pbv_sub(pbv_load(b->px + i), apx), t));
+    pbv py = pbv_add(apy, pbv_mul(pbv_sub(pbv_load(b->py + i), apy), t));
+    pbv pz = pbv_add(apz, pbv_mul(pbv_sub(pbv_load(b->pz + i), apz), t));
+
+    r32 *m = models + 16 * i;
+    pbv_store4(m, 16, 0, m00, m01, m02, zero);
+    pbv_store4(m, 16, 4, m10, m11, m12, zero);
+    pbv_store4(m, 16, 8, m20, m21, m22, zero);
+    pbv_store4(m, 16, 12, px, py, pz, one);
+
+    if (normals)
+    {
+      r32 *n = normals + 12 * i;
+      pbv_store4(n, 12, 0, m00, m01, m02, zero);
+      pbv_store4(n, 12, 4, m10, m11, m12, zero);
+      pbv_store4(n, 12, 8, m20, m21, m22, zero);
+    }
+  }
+#endif
+
+  for (; i < end; ++i)
+    pose_batch_scalar(a, b, alpha, i, models + 16 * i, normals ? normals + 12 * i : nullptr);
+}
+
+#endif // TRANSFORM_BATCH_H